@@ -7,5 +7,7 @@
 #include <sigmod/query.hh>
 #include <sigmod/record.hh>
 #include <sigmod/random.hh>
+#include <sigmod/solution.hh>
+#include <sigmod/tree.hh>
 
 #endif
@@ -0,0 +1,158 @@
+#ifndef SIGMOD_CATEGORIES_HH
+#define SIGMOD_CATEGORIES_HH
+
+#include <sigmod/tree.hh>
+#include <sigmod/memory.hh>
+#ifdef ENABLE_OMP
+#include <parallel/algorithm>
+#endif
+
+/* the records with C == value, as the range by_C[start, end) of Categories */
+struct Category {
+    float32_t value;
+    uint32_t start;
+    uint32_t end;
+    /* only for categories of at least CATEGORY_INDEX_LENGTH records */
+    Tree* tree;
+
+    inline uint32_t length() const { return end - start; }
+};
+
+/* The database partitioned by C, so that BY_C and BY_C_AND_T queries only
+ * touch the records of their category: small categories are scanned
+ * exhaustively, large ones get a tree of their own. */
+struct Categories {
+    uint32_t length;
+    Category* categories;
+    uint32_t* by_C;
+
+    template <typename DB>
+    static Categories* New(const DB& db) {
+        uint32_t* by_C = smalloc<uint32_t>(std::max<uint32_t>(db.length, 1), "categories", MEMORY_CATEGORIES);
+        for (uint32_t i = 0; i < db.length; i++) {
+            by_C[i] = i;
+        }
+        auto by_value = [&db](const uint32_t& a, const uint32_t& b) {
+            const float32_t A = view_of(db, a).C;
+            const float32_t B = view_of(db, b).C;
+            if (A != B) {
+                return A < B;
+            } else {
+                return a < b;
+            }
+        };
+        #ifdef ENABLE_OMP
+        __gnu_parallel::sort(by_C, by_C + db.length, by_value);
+        #else
+        std::sort(by_C, by_C + db.length, by_value);
+        #endif
+
+        uint32_t length = 0;
+        for (uint32_t i = 0; i < db.length; i++) {
+            if (i == 0 || view_of(db, by_C[i]).C != view_of(db, by_C[i - 1]).C)
+                length++;
+        }
+
+        Category* categories = smalloc<Category>(std::max<uint32_t>(length, 1), "categories", MEMORY_CATEGORIES);
+        uint32_t category = 0;
+        for (uint32_t i = 0; i < db.length; i++) {
+            if (i == 0 || view_of(db, by_C[i]).C != view_of(db, by_C[i - 1]).C) {
+                if (i != 0)
+                    categories[category++].end = i;
+                categories[category] = { view_of(db, by_C[i]).C, i, i, nullptr };
+            }
+        }
+        if (length > 0)
+            categories[category].end = db.length;
+
+        #ifdef ENABLE_OMP
+        #pragma omp parallel
+        #pragma omp single
+        #endif
+        for (uint32_t i = 0; i < length; i++) {
+            if (categories[i].length() < CATEGORY_INDEX_LENGTH)
+                continue;
+            #ifdef ENABLE_OMP
+            #pragma omp task firstprivate(i) shared(db, categories, by_C)
+            #endif
+            categories[i].tree = Tree::New(db, by_C + categories[i].start, categories[i].length());
+        }
+
+        Categories* result = smalloc<Categories>(1, "categories", MEMORY_CATEGORIES);
+        result->length = length;
+        result->categories = categories;
+        result->by_C = by_C;
+        return result;
+    }
+
+    static void Free(Categories*& categories) {
+        if (categories != nullptr) {
+            for (uint32_t i = 0; i < categories->length; i++) {
+                Tree::Free(categories->categories[i].tree);
+            }
+            sfree(categories->categories);
+            sfree(categories->by_C);
+            sfree(categories);
+            categories = nullptr;
+        }
+    }
+
+    /* nullptr if no record has C == value */
+    const Category* find(const float32_t value) const {
+        const Category* begin = categories;
+        const Category* end = categories + length;
+        const Category* category = std::lower_bound(begin, end, value,
+            [](const Category& category, const float32_t value) {
+                return category.value < value;
+            });
+        if (category == end || category->value != value)
+            return nullptr;
+        return category;
+    }
+
+    static inline bool handles(const Query& query) {
+        const uint32_t query_type = (uint32_t) query.query_type;
+        return query_type == BY_C || query_type == BY_C_AND_T;
+    }
+
+    /* assumes handles(query) */
+    template <typename DB>
+    void search(const DB& db, const Query& query, Scoreboard& scoreboard) const {
+        const Category* category = find(query.v);
+        if (category == nullptr)
+            return;
+        if (category->tree != nullptr) {
+            category->tree->search(db, query, scoreboard);
+            return;
+        }
+        scan(db, *category, query, scoreboard);
+    }
+
+    /* exhaustive and exact, whatever the size of the category; returns how many records matched */
+    template <typename DB>
+    uint32_t scan(const DB& db, const Category& category, const Query& query, Scoreboard& scoreboard) const {
+        uint32_t matched = 0;
+        const QueryBounds bounds = bounds_of(db, query);
+        for (uint32_t i = category.start; i < category.end; i++) {
+            const uint32_t index = by_C[i];
+            const auto& record = view_of(db, index);
+            if (!check_if_elegible_by_T(query, record))
+                continue;
+            matched++;
+            if (scoreboard.full() && pruned(db, index, bounds, scoreboard.top().score)) {
+                PROFILE_COUNT(COUNTER_PRUNED_RECORDS);
+                continue;
+            }
+            if (scoreboard.full()) {
+                const score_t score = bounded_distance(query, record, scoreboard.top().score);
+                if (score < scoreboard.top().score)
+                    scoreboard.pushf(index, score);
+            } else {
+                scoreboard.add(index, fast_distance(query, record));
+            }
+        }
+        return matched;
+    }
+};
+
+#endif
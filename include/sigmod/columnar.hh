@@ -0,0 +1,112 @@
+#ifndef SIGMOD_COLUMNAR_HH
+#define SIGMOD_COLUMNAR_HH
+
+#include <sigmod/database.hh>
+#include <sigmod/metrics.hh>
+#include <sigmod/pca.hh>
+#include <sigmod/query.hh>
+
+/* every vector is padded up to a whole number of 64 byte lines: with ENABLE_METRICS_PRUNING
+ * the Metrics of the vector come right after it, then zeros (distances never read past the vector) */
+const uint32_t vector_alignment = 64;
+const uint32_t vector_stride = ((vector_num_dimension * sizeof(float32_t) + vector_alignment - 1)
+                                / vector_alignment) * vector_alignment / sizeof(float32_t);
+
+static_assert(vector_stride - vector_num_dimension >= 2, "the metrics are kept in the padding of the vectors");
+
+/* structure-of-arrays copy of a Database: filters only ever touch C and T.
+ * With ENABLE_PCA, projections holds the PCA_COMPONENTS coordinates of every
+ * vector along the components of pca, one row of floats per record. */
+struct ColumnarDatabase {
+    uint32_t length;
+    float32_t* C;
+    float32_t* T;
+    float32_t* vectors;
+    PCA* pca;
+    float32_t* projections;
+};
+
+/* what a row of a ColumnarDatabase looks like to filters and distances */
+struct RecordView {
+    float32_t C;
+    float32_t T;
+    const float32_t* fields;
+};
+
+ColumnarDatabase BuildColumnarDatabase(const Database& database);
+/* record i becomes record order[i], order being a permutation of the records */
+void PermuteColumnarDatabase(ColumnarDatabase& database, const uint32_t* order);
+void FreeColumnarDatabase(ColumnarDatabase& database);
+
+/* uniform row access, so that the same code can run over either layout */
+inline const Record& view_of(const Database& database, const uint32_t index) {
+    return database.records[index];
+}
+
+inline RecordView view_of(const ColumnarDatabase& database, const uint32_t index) {
+    return {
+        .C = database.C[index],
+        .T = database.T[index],
+        .fields = database.vectors + (uint64_t) index * vector_stride
+    };
+}
+
+/* the components trees may split along, see ENABLE_PCA_SPLITS */
+inline const PCA* pca_of(const Database&) {
+    return nullptr;
+}
+
+inline const PCA* pca_of(const ColumnarDatabase& database) {
+    return database.pca;
+}
+
+/* What scans compute once per query to reject records without their distance,
+ * see ENABLE_METRICS_PRUNING and ENABLE_PCA; only the columnar database keeps
+ * what the records side needs, the other layouts never prune. */
+struct QueryBounds {
+    Metrics metrics;
+    float32_t projection[PCA_COMPONENTS];
+};
+
+inline QueryBounds bounds_of(const Database&, const Query&) {
+    return {};
+}
+
+inline QueryBounds bounds_of(const ColumnarDatabase& database, const Query& query) {
+    QueryBounds bounds = {};
+    #ifdef ENABLE_METRICS_PRUNING
+    bounds.metrics = metrics_of(query);
+    #endif
+    #ifdef ENABLE_PCA
+    database.pca->project(query.fields, bounds.projection);
+    #else
+    (void) database;
+    #endif
+    (void) query;
+    return bounds;
+}
+
+/* true when the record is sure to be at least threshold away from the query of bounds */
+inline bool pruned(const Database&, const uint32_t, const QueryBounds&, const score_t) {
+    return false;
+}
+
+inline bool pruned(const ColumnarDatabase& database, const uint32_t index,
+                   const QueryBounds& bounds, const score_t threshold) {
+    #ifdef ENABLE_PCA
+    if (projected_distance(bounds.projection, database.projections + (uint64_t) index * PCA_COMPONENTS) >= threshold)
+        return true;
+    #endif
+    #ifdef ENABLE_METRICS_PRUNING
+    const float32_t* padding = database.vectors + (uint64_t) index * vector_stride + vector_num_dimension;
+    if (metrics_bound(bounds.metrics, { .diagonal = padding[0], .spread = padding[1] }) >= threshold)
+        return true;
+    #endif
+    (void) database;
+    (void) index;
+    (void) bounds;
+    (void) threshold;
+    return false;
+}
+
+#endif
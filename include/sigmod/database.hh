@@ -2,15 +2,21 @@
 #define SIGMOD_DATABASE_HH
 
 #include <sigmod/record.hh>
+#include <sigmod/mapping.hh>
 #include <string>
 
 struct Database {
     uint32_t length;
     Record* records;
+    /* set when records points into a read-only file mapping */
+    Mapping mapping;
 };
 
 Database ReadDatabase(std::string input_path);
+Database MapDatabase(std::string input_path);
 void WriteDatabase(const Database& database, std::string input_path);
 void FreeDatabase(Database& database);
+/* 64 bit fingerprint of length and records, used to tell apart the data an index was built on */
+uint64_t ChecksumDatabase(const Database& database);
 
 #endif
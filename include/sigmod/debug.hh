@@ -13,13 +13,12 @@ inline void Panic(const std::string s) {
     exit(1);
 }
 
+/* the time since the last call, and the memory allocated now and at the peak in between */
 void LogTime(const std::string s);
 
-extern long long SIGMOD_MEMORY_TRACKER;
-extern long long SIGMOD_DISTANCE_COMPUTATIONS;
-
 std::string BytesToString(long double bytes);
 std::string LengthToString(long double length);
+/* the bytes allocated through memory.hh since the start, by tag, and the RSS of the process */
 void LogMemory(const std::string s);
 
 #endif
@@ -0,0 +1,44 @@
+#ifndef SIGMOD_DISTANCE_HH
+#define SIGMOD_DISTANCE_HH
+
+#include <sigmod/config.hh>
+
+/* Squared euclidean distance kernels over vector_num_dimension floats.
+ * They accumulate in float lanes and never take the square root, so
+ * their results can only be compared with each other.
+ *
+ * The bounded variant may stop as soon as the partial sum exceeds bound:
+ * in that case it returns some value greater than bound.
+ *
+ * The dot kernel is the plain inner product, used to place vectors
+ * with respect to hyperplanes.
+ *
+ * The quantized kernels compare a float vector with one stored as uint8
+ * codes, decoding dimension d as minimum[d] + step[d] * code[d], and give up
+ * early like the float ones when bounded.
+ * codes, minimum and step must be readable up to a multiple of 16 dimensions,
+ * padded with zeros.
+ * */
+
+typedef float32_t (*distance_kernel_t)(const float32_t* a, const float32_t* b);
+typedef float32_t (*bounded_distance_kernel_t)(const float32_t* a, const float32_t* b, float32_t bound);
+typedef float32_t (*dot_kernel_t)(const float32_t* a, const float32_t* b);
+typedef float32_t (*quantized_distance_kernel_t)(const float32_t* a, const uint8_t* codes,
+                                                 const float32_t* minimum, const float32_t* step);
+typedef float32_t (*bounded_quantized_distance_kernel_t)(const float32_t* a, const uint8_t* codes,
+                                                         const float32_t* minimum, const float32_t* step,
+                                                         float32_t bound);
+
+struct DistanceKernels {
+    const char* name;
+    distance_kernel_t full;
+    bounded_distance_kernel_t bounded;
+    dot_kernel_t dot;
+    quantized_distance_kernel_t quantized;
+    bounded_quantized_distance_kernel_t bounded_quantized;
+};
+
+/* picked once at startup by looking at the features of the running cpu */
+extern const DistanceKernels SIGMOD_DISTANCE_KERNELS;
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef SIGMOD_EXACT_HH
+#define SIGMOD_EXACT_HH
+
+#include <sigmod/scoreboard.hh>
+#include <sigmod/columnar.hh>
+#include <sigmod/memory.hh>
+#include <sigmod/flags.hh>
+
+/* Exact k-NN for many queries at once, blocked for the caches:
+ * a tile of EXACT_QUERY_TILE queries is compared against tiles of
+ * EXACT_RECORD_TILE records, so that each record tile is loaded once
+ * and stays in cache for the whole query tile.
+ *
+ * Distances are computed directly by the bounded kernel against the furthest
+ * candidate of each query, rather than from norms and dot products, whose
+ * cancellation can swap near ties. The final candidates are then scored again
+ * with the kernel of fast_distance, so that their scores are exactly those.
+ *
+ * Filters are applied through a mask per query and record tile, records
+ * outside of it never get to the kernels. */
+struct Exact {
+    uint32_t length;
+
+    template <typename DB>
+    static Exact* New(const DB& db) {
+        Exact* exact = smalloc<Exact>(1, "exact");
+        exact->length = db.length;
+        return exact;
+    }
+
+    static void Free(Exact*& exact) {
+        if (exact != nullptr) {
+            sfree(exact);
+            exact = nullptr;
+        }
+    }
+
+    /* Answers queries[i] into scoreboards[i], which are expected to be empty.
+     * Without filtered every record is a candidate, whatever the query type:
+     * that is what ground truth for unfiltered search needs. */
+    template <typename DB>
+    void search(const DB& db, const Query* const* queries, const uint32_t queries_length,
+                Scoreboard* scoreboards, const bool filtered = true) const {
+        for (uint32_t first = 0; first < queries_length; first += EXACT_QUERY_TILE) {
+            const uint32_t tile = std::min<uint32_t>(EXACT_QUERY_TILE, queries_length - first);
+            search_tile(db, queries + first, tile, scoreboards + first, filtered);
+        }
+    }
+
+    template <typename DB>
+    void search(const DB& db, const Query& query, Scoreboard& scoreboard) const {
+        const Query* queries[1] = { &query };
+        search(db, queries, 1, &scoreboard);
+    }
+
+    template <typename DB>
+    void search_tile(const DB& db, const Query* const* queries, const uint32_t tile,
+                     Scoreboard* scoreboards, const bool filtered) const {
+        static_assert(EXACT_RECORD_TILE <= 64, "a record tile has to fit in a 64 bit mask");
+        const distance_kernel_t full = SIGMOD_DISTANCE_KERNELS.full;
+        const bounded_distance_kernel_t bounded = SIGMOD_DISTANCE_KERNELS.bounded;
+        uint64_t masks[EXACT_QUERY_TILE];
+        for (uint32_t start = 0; start < length; start += EXACT_RECORD_TILE) {
+            const uint32_t end = std::min<uint32_t>(start + EXACT_RECORD_TILE, length);
+            const uint64_t all = end - start == 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << (end - start)) - 1;
+            uint64_t any = 0;
+            for (uint32_t q = 0; q < tile; q++) {
+                masks[q] = filtered ? mask_of(db, *queries[q], start, end) : all;
+                any |= masks[q];
+            }
+            if (any == 0)
+                continue;
+
+            for (uint32_t q = 0; q < tile; q++) {
+                uint64_t mask = masks[q];
+                Scoreboard& scoreboard = scoreboards[q];
+                while (mask != 0) {
+                    const uint32_t index = start + __builtin_ctzll(mask);
+                    mask &= mask - 1;
+                    if (scoreboard.full()) {
+                        const score_t score = bounded(queries[q]->fields, view_of(db, index).fields, scoreboard.top().score);
+                        if (score < scoreboard.top().score)
+                            scoreboard.pushf(index, score);
+                    } else {
+                        scoreboard.add(index, full(queries[q]->fields, view_of(db, index).fields));
+                    }
+                }
+            }
+        }
+
+        /* the bounded kernel may round differently from the full one */
+        Candidate candidates[k_nearest_neighbors];
+        for (uint32_t q = 0; q < tile; q++) {
+            const uint32_t count = scoreboards[q].drain(candidates);
+            for (uint32_t i = 0; i < count; i++) {
+                scoreboards[q].add(candidates[i].index, full(queries[q]->fields, view_of(db, candidates[i].index).fields));
+            }
+        }
+    }
+
+    /* bit i is set when record start + i passes the filters of query */
+    template <typename DB>
+    static inline uint64_t mask_of(const DB& db, const Query& query, const uint32_t start, const uint32_t end) {
+        uint64_t mask = 0;
+        for (uint32_t i = start; i < end; i++) {
+            mask |= (uint64_t) check_if_elegible(query, view_of(db, i)) << (i - start);
+        }
+        return mask;
+    }
+};
+
+#endif
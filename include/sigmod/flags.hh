@@ -4,10 +4,91 @@
 /* FLAGS */
 
 #define ENABLE_OMP
+#define ENABLE_MMAP
+#define ENABLE_COLUMNAR_DATABASE
+#define ENABLE_PERSISTENT_INDEX
+#define ENABLE_LEAF_LAYOUT
+#define ENABLE_FOREST
+#define FOREST_LENGTH 8
+#define ENABLE_BEST_FIRST
+#define SEARCH_LEAF_BUDGET 64
+#define SEARCH_DISTANCE_BUDGET UINT32_MAX
+#define ENABLE_CATEGORIES
+#define ENABLE_PLANNER
+#define PLANNER_SCAN_LENGTH 20000
+/* the planner scans every category of up to PLANNER_SCAN_LENGTH records, so only larger ones get a tree */
+#ifdef ENABLE_PLANNER
+#define CATEGORY_INDEX_LENGTH (PLANNER_SCAN_LENGTH + 1)
+#else
+#define CATEGORY_INDEX_LENGTH 10000
+#endif
+#define PLANNER_T_BUCKETS 1024
+/* #define ENABLE_METRICS_PRUNING */
+/* #define ENABLE_PCA */
+#define PCA_COMPONENTS 16
+#define PCA_TRAINING_LENGTH 16384
+/* #define ENABLE_PCA_SPLITS */
+/* #define ENABLE_EXACT_ENGINE */
+#define EXACT_QUERY_TILE 16
+#define EXACT_RECORD_TILE 64
+#define ENABLE_QUANTIZATION
+#define QUANTIZED_CANDIDATES 200
+/* #define ENABLE_PQ_ENGINE */
+#define PQ_SUBSPACES 20
+#define PQ_CENTROIDS 256
+#define PQ_CANDIDATES 500
+#define PQ_TRAINING_LENGTH 16384
+#define PQ_TRAINING_ITERATIONS 10
+#define GRAPH_DEGREE 24
+#define GRAPH_POOL 48
+#define GRAPH_ALPHA 1.2
+#define GRAPH_BEAM 512
+#define GRAPH_VISIT_BUDGET 8192
+#define GRAPH_LONG_LINKS 2
 #define PARTITION_LENGTH 100
 #define TREE_NODE_SIZE 100 
 #define LINKS_SIZE 100
+#define QUERY_CHUNK_SIZE 16
+#define ENABLE_QUERY_SCHEDULE
+#define TREE_LEAF_LENGTH 100
+#define TREE_MIN_SPLIT_FRACTION 4
+#define TREE_SPLIT_ATTEMPTS 4
+#define PARALLEL_BUILD_LENGTH 10000
+#define PARALLEL_PARTITION_LENGTH 100000
+#define PARTITION_GRAIN_SIZE 8192
+#define ENABLE_PROFILE
+/* #define ENABLE_PERF_COUNTERS */
+/* #define ENABLE_HUGE_PAGES */
+#define HUGE_PAGE_LENGTH (2u << 20)
 
 /* RULES */
 
+#if defined(ENABLE_QUANTIZATION) && !defined(ENABLE_COLUMNAR_DATABASE)
+#error "ENABLE_QUANTIZATION is built from the columnar database, it needs ENABLE_COLUMNAR_DATABASE"
+#endif
+
+#if defined(ENABLE_LEAF_LAYOUT) && !defined(ENABLE_COLUMNAR_DATABASE)
+#error "ENABLE_LEAF_LAYOUT moves the records of the columnar database, it needs ENABLE_COLUMNAR_DATABASE"
+#endif
+
+#if defined(ENABLE_PCA) && !defined(ENABLE_COLUMNAR_DATABASE)
+#error "ENABLE_PCA keeps its projections in the columnar database, it needs ENABLE_COLUMNAR_DATABASE"
+#endif
+
+#if defined(ENABLE_PCA_SPLITS) && !defined(ENABLE_PCA)
+#error "ENABLE_PCA_SPLITS splits along the components of ENABLE_PCA"
+#endif
+
+#if defined(ENABLE_PQ_ENGINE) && defined(ENABLE_QUANTIZATION)
+#error "ENABLE_PQ_ENGINE already reranks its own candidates, it can't run over ENABLE_QUANTIZATION"
+#endif
+
+#if GRAPH_LONG_LINKS >= GRAPH_DEGREE
+#error "GRAPH_LONG_LINKS are taken from the GRAPH_DEGREE links of every record, some have to be left for the nearest"
+#endif
+
+#if defined(ENABLE_PERF_COUNTERS) && !defined(ENABLE_PROFILE)
+#error "ENABLE_PERF_COUNTERS reads the counters of the threads ENABLE_PROFILE registers, it needs ENABLE_PROFILE"
+#endif
+
 #endif
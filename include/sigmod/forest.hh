@@ -0,0 +1,73 @@
+#ifndef SIGMOD_FOREST_HH
+#define SIGMOD_FOREST_HH
+
+#include <sigmod/tree.hh>
+#include <sigmod/memory.hh>
+
+/* Independently seeded trees over the same database, searched together
+ * under one budget per query. */
+struct Forest {
+    uint32_t length;
+    Tree** trees;
+    SearchBudget budget;
+
+    /* trees are taken over by the forest, which frees them */
+    static Forest* From(Tree** trees, uint32_t length, SearchBudget budget) {
+        Forest* forest = smalloc<Forest>(1, "forest", MEMORY_TREE_NODES);
+        forest->length = length;
+        forest->trees = trees;
+        forest->budget = budget;
+        return forest;
+    }
+
+    template <typename DB>
+    static Forest* New(const DB& db, uint32_t length, SearchBudget budget, uint32_t seed = 0) {
+        Tree** trees = smalloc<Tree*>(length, "forest trees", MEMORY_TREE_NODES);
+        for (uint32_t i = 0; i < length; i++) {
+            trees[i] = Tree::New(db, seed + i);
+        }
+        return From(trees, length, budget);
+    }
+
+    static void Free(Forest*& forest) {
+        if (forest != nullptr) {
+            for (uint32_t i = 0; i < forest->length; i++) {
+                Tree::Free(forest->trees[i]);
+            }
+            sfree(forest->trees);
+            sfree(forest);
+            forest = nullptr;
+        }
+    }
+
+    template <typename DB, typename Board>
+    void search(const DB& db, const Query& query, Board& scoreboard) const {
+        #ifdef ENABLE_BEST_FIRST
+        SearchBestFirst(db, trees, length, query, scoreboard, budget);
+        #else
+        search_depth_first(db, query, scoreboard);
+        #endif
+    }
+
+    /* Every tree gets an equal share of what is left of the budget, so whatever
+     * a tree doesn't spend goes to the following ones. */
+    template <typename DB, typename Board>
+    void search_depth_first(const DB& db, const Query& query, Board& scoreboard) const {
+        thread_local VisitedSet visited;
+        visited.clear();
+        SearchBudget left = budget;
+        for (uint32_t i = 0; i < length && !left.exhausted(); i++) {
+            const uint32_t trees_left = length - i;
+            SearchBudget share = {
+                .leaves = std::max<uint32_t>(1, left.leaves / trees_left),
+                .distances = std::max<uint32_t>(1, left.distances / trees_left)
+            };
+            const SearchBudget given = share;
+            trees[i]->search(db, query, scoreboard, share, visited);
+            left.leaves -= given.leaves - share.leaves;
+            left.distances -= given.distances - share.distances;
+        }
+    }
+};
+
+#endif
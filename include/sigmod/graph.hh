@@ -0,0 +1,228 @@
+#ifndef SIGMOD_GRAPH_HH
+#define SIGMOD_GRAPH_HH
+
+#include <sigmod/tree.hh>
+#include <sigmod/scoreboard.hh>
+#include <sigmod/memory.hh>
+#include <sigmod/flags.hh>
+#include <algorithm>
+#include <vector>
+
+/* Proximity graph (Vamana-like) with at most GRAPH_DEGREE out-links per record:
+ *  - candidates of a record are the other records of its leaf in every tree given to New
+ *  - the nearest GRAPH_POOL of them are pruned by the GRAPH_ALPHA rule, so that links
+ *    towards records already reachable through a nearer link are dropped
+ *  - every link is then added back reversed, and the union pruned again
+ *  - the last GRAPH_LONG_LINKS links of every record go to random records, which
+ *    pruning would never keep, so that clusters no leaf spans are still connected
+ * Every step works on one record at a time, so the build is parallel without locks.
+ *
+ * Searches start from the records of the leaf the query falls in, in the first tree
+ * given to New, and expand the nearest unexpanded record first. Filters are applied during the traversal:
+ * records that don't pass them are still expanded, so the search can cross regions
+ * without matches, but only the ones that do pass enter the beam, and the search
+ * stops once the beam holds GRAPH_BEAM matches nearer than anything left to expand. */
+struct Graph {
+    uint32_t length;
+    uint32_t* degrees;
+    /* [record][GRAPH_DEGREE], the first degrees[record] are used */
+    uint32_t* neighbors;
+    /* where the searches start, borrowed from the engine the graph was built from */
+    const Tree* entry_tree;
+
+    /* the links left by pruning, GRAPH_LONG_LINKS go to random records */
+    static const uint32_t near_degree = GRAPH_DEGREE - GRAPH_LONG_LINKS;
+
+    template <typename DB>
+    static Graph* New(const DB& db, const Tree* const* trees, const uint32_t trees_length) {
+        Graph* graph = smalloc<Graph>(1, "graph", MEMORY_GRAPH);
+        graph->length = db.length;
+        graph->degrees = smalloc<uint32_t>(std::max<uint32_t>(db.length, 1), "graph degrees", MEMORY_GRAPH);
+        graph->neighbors = smalloc<uint32_t>(std::max<uint64_t>((uint64_t) db.length * GRAPH_DEGREE, 1), "graph neighbors", MEMORY_GRAPH);
+        graph->entry_tree = trees[0];
+        if (db.length == 0)
+            return graph;
+
+        #ifdef ENABLE_OMP
+        #pragma omp parallel
+        #endif
+        {
+            std::vector<uint32_t> indices;
+            std::vector<Candidate> pool;
+            #ifdef ENABLE_OMP
+            #pragma omp for schedule(dynamic, 256)
+            #endif
+            for (uint32_t i = 0; i < db.length; i++) {
+                indices.clear();
+                for (uint32_t t = 0; t < trees_length; t++) {
+                    const Node& node = trees[t]->nodes[trees[t]->locate(view_of(db, i))];
+                    indices.insert(indices.end(), trees[t]->by_C + node.start, trees[t]->by_C + node.end);
+                }
+                graph->link(db, i, indices, pool);
+            }
+        }
+
+        /* reversed links, as many as fit, in whatever order the threads get to them */
+        uint32_t* reversed_degrees = smalloc<uint32_t>(db.length, "graph reversed degrees", MEMORY_GRAPH);
+        uint32_t* reversed = smalloc<uint32_t>((uint64_t) db.length * GRAPH_DEGREE, "graph reversed", MEMORY_GRAPH);
+        std::fill(reversed_degrees, reversed_degrees + db.length, 0);
+        #ifdef ENABLE_OMP
+        #pragma omp parallel for schedule(static)
+        #endif
+        for (uint32_t i = 0; i < db.length; i++) {
+            for (uint32_t n = 0; n < graph->degrees[i]; n++) {
+                const uint32_t j = graph->neighbors[(uint64_t) i * GRAPH_DEGREE + n];
+                uint32_t slot;
+                #ifdef ENABLE_OMP
+                #pragma omp atomic capture
+                #endif
+                slot = reversed_degrees[j]++;
+                if (slot < GRAPH_DEGREE)
+                    reversed[(uint64_t) j * GRAPH_DEGREE + slot] = i;
+            }
+        }
+
+        #ifdef ENABLE_OMP
+        #pragma omp parallel
+        #endif
+        {
+            std::vector<uint32_t> indices;
+            std::vector<Candidate> pool;
+            #ifdef ENABLE_OMP
+            #pragma omp for schedule(dynamic, 256)
+            #endif
+            for (uint32_t i = 0; i < db.length; i++) {
+                const uint32_t* links = graph->neighbors + (uint64_t) i * GRAPH_DEGREE;
+                const uint32_t* back = reversed + (uint64_t) i * GRAPH_DEGREE;
+                indices.assign(links, links + graph->degrees[i]);
+                indices.insert(indices.end(), back, back + std::min<uint32_t>(reversed_degrees[i], GRAPH_DEGREE));
+                graph->link(db, i, indices, pool);
+            }
+        }
+        sfree(reversed_degrees);
+        sfree(reversed);
+
+        /* the targets only depend on the record, whatever the order threads get to them */
+        #ifdef ENABLE_OMP
+        #pragma omp parallel for schedule(static)
+        #endif
+        for (uint32_t i = 0; i < db.length; i++) {
+            uint64_t key = i;
+            Xoshiro256 generator = Xoshiro256::Seeded(SplitMix64(key));
+            uint32_t* links = graph->neighbors + (uint64_t) i * GRAPH_DEGREE;
+            for (uint32_t l = 0; l < GRAPH_LONG_LINKS && db.length > 1; l++) {
+                uint32_t j = generator.uniform(0u, db.length);
+                while (j == i)
+                    j = generator.uniform(0u, db.length);
+                links[graph->degrees[i]++] = j;
+            }
+        }
+        return graph;
+    }
+
+    static void Free(Graph*& graph);
+
+    /* Replaces the links of record with at most near_degree of the nearest GRAPH_POOL of indices,
+     * which may hold duplicates and record itself. A candidate c is dropped when a
+     * kept link s has GRAPH_ALPHA·d(s, c) <= d(record, c); the slots left are
+     * then filled with the nearest dropped ones. */
+    template <typename DB>
+    void link(const DB& db, const uint32_t record, std::vector<uint32_t>& indices, std::vector<Candidate>& pool) {
+        std::sort(indices.begin(), indices.end());
+        indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+        pool.clear();
+        const auto& vector = view_of(db, record);
+        for (const uint32_t index : indices) {
+            if (index != record)
+                pool.emplace_back(index, fast_distance(vector, view_of(db, index)));
+        }
+        auto nearer = [](const Candidate& a, const Candidate& b) {
+            return a.score < b.score || (a.score == b.score && a.index < b.index);
+        };
+        const uint32_t pool_length = std::min<uint32_t>(pool.size(), GRAPH_POOL);
+        std::partial_sort(pool.begin(), pool.begin() + pool_length, pool.end(), nearer);
+
+        /* distances are squared, so is alpha */
+        const score_t alpha = (score_t) GRAPH_ALPHA * (score_t) GRAPH_ALPHA;
+        uint32_t* links = neighbors + (uint64_t) record * GRAPH_DEGREE;
+        bool kept[GRAPH_POOL] = {};
+        uint32_t degree = 0;
+        for (uint32_t c = 0; c < pool_length && degree < near_degree; c++) {
+            const auto& candidate = view_of(db, pool[c].index);
+            bool dominated = false;
+            for (uint32_t s = 0; s < degree && !dominated; s++) {
+                dominated = alpha * fast_distance(candidate, view_of(db, links[s])) <= pool[c].score;
+            }
+            if (!dominated) {
+                links[degree++] = pool[c].index;
+                kept[c] = true;
+            }
+        }
+        for (uint32_t c = 0; c < pool_length && degree < near_degree; c++) {
+            if (!kept[c])
+                links[degree++] = pool[c].index;
+        }
+        degrees[record] = degree;
+    }
+
+    template <typename DB, typename Board>
+    void search(const DB& db, const Query& query, Board& scoreboard) const {
+        thread_local VisitedSet visited;
+        thread_local FixedScoreboard<GRAPH_BEAM> beam;
+        thread_local std::vector<Candidate> frontier;
+        thread_local Candidate found[GRAPH_BEAM];
+        if (length == 0)
+            return;
+        auto further = [](const Candidate& a, const Candidate& b) { return a.score > b.score; };
+
+        visited.clear();
+        beam.clear();
+        frontier.clear();
+        uint32_t computed = 0;
+        const Node& entries = entry_tree->nodes[entry_tree->locate(query)];
+        for (uint32_t e = entries.start; e < entries.end; e++) {
+            const uint32_t index = entry_tree->by_C[e];
+            if (!visited.insert(index))
+                continue;
+            const auto& record = view_of(db, index);
+            const score_t score = fast_distance(query, record);
+            computed++;
+            frontier.emplace_back(index, score);
+            if (check_if_elegible(query, record))
+                beam.push(index, score);
+        }
+        std::make_heap(frontier.begin(), frontier.end(), further);
+
+        while (!frontier.empty() && computed < GRAPH_VISIT_BUDGET) {
+            std::pop_heap(frontier.begin(), frontier.end(), further);
+            const Candidate nearest = frontier.back();
+            frontier.pop_back();
+            if (beam.full() && nearest.score > beam.top().score)
+                break;
+            PROFILE_COUNT(COUNTER_NODES);
+
+            const uint32_t* links = neighbors + (uint64_t) nearest.index * GRAPH_DEGREE;
+            for (uint32_t n = 0; n < degrees[nearest.index]; n++) {
+                const uint32_t index = links[n];
+                if (!visited.insert(index))
+                    continue;
+                const auto& record = view_of(db, index);
+                const score_t score = fast_distance(query, record);
+                computed++;
+                if (beam.full() && score >= beam.top().score)
+                    continue;
+                if (check_if_elegible(query, record))
+                    beam.pushf(index, score);
+                frontier.emplace_back(index, score);
+                std::push_heap(frontier.begin(), frontier.end(), further);
+            }
+        }
+
+        const uint32_t count = beam.drain(found);
+        for (uint32_t i = 0; i < count; i++) {
+            scoreboard.push(found[i].index, found[i].score);
+        }
+    }
+};
+
+#endif
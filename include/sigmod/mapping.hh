@@ -0,0 +1,21 @@
+#ifndef SIGMOD_MAPPING_HH
+#define SIGMOD_MAPPING_HH
+
+#include <cstdint>
+#include <string>
+
+/* a read-only view of a whole file, address is nullptr when unused */
+struct Mapping {
+    void* address;
+    uint64_t length;
+};
+
+Mapping MapFile(std::string input_path);
+void UnmapFile(Mapping& mapping);
+uint64_t FileSize(std::string input_path);
+bool FileExists(std::string input_path);
+
+/* panics unless the file holds exactly a uint32_t header plus length items */
+void CheckFileLength(std::string input_path, uint64_t file_size, uint32_t length, uint64_t item_size);
+
+#endif
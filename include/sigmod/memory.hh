@@ -4,31 +4,89 @@
 #include <cstring>
 #include <string>
 #include <cstdint>
-#include <stdexcept>
+#include <new>
 #include <sigmod/debug.hh>
+#include <sigmod/flags.hh>
+
+/* What the allocated bytes are accounted to */
+enum memory_tag_t {
+  MEMORY_DATABASE = 0,
+  MEMORY_QUERY_SET = 1,
+  MEMORY_TREE_NODES = 2,
+  MEMORY_HYPERPLANES = 3,
+  MEMORY_LEAF_INDICES = 4,
+  MEMORY_QUANTIZED = 5,
+  MEMORY_GRAPH = 6,
+  MEMORY_CATEGORIES = 7,
+  MEMORY_PLANNER = 8,
+  MEMORY_SOLUTION = 9,
+  MEMORY_OTHER = 10
+};
+
+const uint32_t memory_tag_count = 11;
+
+const uint64_t cache_line_length = 64;
+
+extern const char* memory_tag_names[memory_tag_count];
+
+/* Bytes live through the helpers below, in total and by tag. Peaks are since the
+ * start, phase_peak since the last phase (see ProfilePhase). rss and peak_rss
+ * are those of the process, so they count mapped files and everything else too. */
+struct MemoryUsage {
+  uint64_t current;
+  uint64_t peak;
+  uint64_t phase_peak;
+  uint64_t by_tag[memory_tag_count];
+  uint64_t peak_by_tag[memory_tag_count];
+  uint64_t rss;
+  uint64_t peak_rss;
+};
+
+MemoryUsage ReadMemoryUsage();
+/* ReadMemoryUsage, then starts a new phase_peak */
+MemoryUsage EndMemoryPhase();
+
+/* Accounting of allocations made elsewhere, e.g. by new[]; ptr may not be tracked twice */
+void TrackAllocation(const void* ptr, uint64_t bytes, memory_tag_t tag);
+void UntrackAllocation(const void* ptr);
+
+/* malloc, calloc, realloc and free with accounting. They Panic when out of memory,
+ * and Deallocate ignores nullptr, like free. */
+void* Allocate(uint64_t bytes, memory_tag_t tag, const std::string& help);
+void* AllocateZeroed(uint64_t bytes, memory_tag_t tag, const std::string& help);
+void* Reallocate(void* ptr, uint64_t bytes, const std::string& help);
+void Deallocate(void* ptr);
+
+/* For the large arrays: aligned to alignment, a power of two, and rounded up to a
+ * multiple of it. With ENABLE_HUGE_PAGES, arrays of HUGE_PAGE_LENGTH or more are aligned
+ * to HUGE_PAGE_LENGTH instead and advised to be backed by transparent huge pages, which
+ * saves TLB misses on the random accesses of the searches. Freed with Deallocate. */
+void* AllocateAligned(uint64_t bytes, uint64_t alignment, memory_tag_t tag, const std::string& help);
 
 template<typename T>
-T* smalloc(uint32_t length = 1, std::string help = "") {
-  const uint32_t n_of_bytes = sizeof(T) * length;
-  T* ptr = new T[length];
+T* smalloc(uint64_t length = 1, std::string help = "", memory_tag_t tag = MEMORY_OTHER) {
+  const uint64_t n_of_bytes = sizeof(T) * length;
+  T* ptr = new (std::nothrow) T[length];
   if (nullptr == ptr) {
     std::string error_message = "no more memory available, was trying to allocate " + BytesToString(n_of_bytes);
     if (help.size() != 0)
       error_message += " for " + help;
-    throw std::runtime_error(error_message);
+    Panic(error_message);
   }
+  TrackAllocation(ptr, n_of_bytes, tag);
   return ptr;
 }
 
 template<typename T>
 void sfree(T* ptr, std::string help = "") {
   if (nullptr != ptr) {
+    UntrackAllocation(ptr);
     delete[] ptr;
   } else {
     std::string error_message = "sfree called on nullptr";
     if (help.size() != 0)
       error_message += " for " + help;
-    throw std::runtime_error(error_message);
+    Panic(error_message);
   }
 }
 #endif
@@ -1,10 +1,11 @@
 #ifndef SIGMOD_METRICS_HH
 #define SIGMOD_METRICS_HH
 #include <sigmod/config.hh>
+#include <algorithm>
 #include <cmath>
 
 template <typename WithFields>
-score_t first_metric(WithFields& with_fields) {
+score_t first_metric(const WithFields& with_fields) {
     score_t sum = 0.0;
     for (uint32_t i = 0; i < vector_num_dimension; i++) {
         sum += with_fields.fields[i] * with_fields.fields[i];
@@ -13,7 +14,7 @@ score_t first_metric(WithFields& with_fields) {
 }
 
 template <typename WithFields>
-score_t second_metric(WithFields& with_fields) {
+score_t second_metric(const WithFields& with_fields) {
     score_t gamma = 0.0;
     for (uint32_t i = 0; i < vector_num_dimension; i++) {
         gamma += with_fields.fields[i];
@@ -30,4 +31,33 @@ score_t second_metric(WithFields& with_fields) {
     return std::sqrt(sum);
 }
 
+/* A vector seen as its component along the diagonal (1, ..., 1) and the rest:
+ * diagonal is the signed coordinate of the first, the sum of the fields over
+ * sqrt(n), and second_metric is the norm of the rest. The two parts are orthogonal
+ * projections, so for any two vectors the distance between their Metrics is
+ * a lower bound on the distance between the vectors (and tighter than |‖q‖ - ‖r‖|). */
+struct Metrics {
+    float32_t diagonal;
+    float32_t spread;
+};
+
+template <typename WithFields>
+Metrics metrics_of(const WithFields& with_fields) {
+    score_t sum = 0.0;
+    for (uint32_t i = 0; i < vector_num_dimension; i++) {
+        sum += with_fields.fields[i];
+    }
+    return {
+        .diagonal = (float32_t) (sum / std::sqrt((score_t) vector_num_dimension)),
+        .spread = (float32_t) second_metric(with_fields)
+    };
+}
+
+/* squared, like fast_distance */
+inline score_t metrics_bound(const Metrics& a, const Metrics& b) {
+    const float32_t diagonal = a.diagonal - b.diagonal;
+    const float32_t spread = a.spread - b.spread;
+    return diagonal * diagonal + spread * spread;
+}
+
 #endif
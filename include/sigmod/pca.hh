@@ -0,0 +1,39 @@
+#ifndef SIGMOD_PCA_HH
+#define SIGMOD_PCA_HH
+
+#include <sigmod/config.hh>
+#include <sigmod/flags.hh>
+
+/* The PCA_COMPONENTS principal directions of a sample of the vectors, unit norm and
+ * orthogonal, by decreasing variance. Projecting two vectors on them is a rotation
+ * followed by a truncation, so the distance between the projections is a lower
+ * bound on the distance between the vectors, and most of it when the variance
+ * is concentrated in a few directions. */
+struct PCA {
+    /* [component][vector_num_dimension] */
+    float32_t components[PCA_COMPONENTS * vector_num_dimension];
+    float32_t variances[PCA_COMPONENTS];
+
+    /* vectors is a matrix of length rows of stride floats, of which PCA_TRAINING_LENGTH are sampled */
+    static PCA* New(const float32_t* vectors, uint32_t length, uint32_t stride);
+    static void Free(PCA*& pca);
+
+    inline const float32_t* component(const uint32_t c) const {
+        return components + (uint64_t) c * vector_num_dimension;
+    }
+
+    /* output[c] := component(c) · fields */
+    void project(const float32_t* fields, float32_t* output) const;
+};
+
+/* squared, like fast_distance */
+inline score_t projected_distance(const float32_t* a, const float32_t* b) {
+    float32_t sum = 0;
+    for (uint32_t c = 0; c < PCA_COMPONENTS; c++) {
+        const float32_t m = a[c] - b[c];
+        sum += m * m;
+    }
+    return sum;
+}
+
+#endif
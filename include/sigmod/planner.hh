@@ -0,0 +1,205 @@
+#ifndef SIGMOD_PLANNER_HH
+#define SIGMOD_PLANNER_HH
+
+#include <sigmod/categories.hh>
+#include <sigmod/memory.hh>
+#include <sigmod/flags.hh>
+#include <cmath>
+#ifdef ENABLE_OMP
+#include <parallel/algorithm>
+#endif
+
+/* How a query gets answered: by the index (the categories or the engine),
+ * or by an exact scan of the records in one of the orderings the planner knows */
+enum route_t {
+    ROUTE_INDEX = 0,
+    ROUTE_SCAN_ALL = 1,
+    ROUTE_SCAN_BY_C = 2,
+    ROUTE_SCAN_BY_T = 3
+};
+
+const uint32_t route_count = 4;
+
+struct Plan {
+    route_t route;
+    /* records expected to match the filters of the query */
+    double estimate;
+    /* records the scan would touch */
+    uint32_t cost;
+    /* a C and T query scanned by C because the index would reach too few of its matches */
+    bool selective;
+};
+
+/* Updated atomically by every thread, estimate errors are only known for scanned queries */
+struct PlannerCounters {
+    uint64_t routed[query_type_count][route_count];
+    /* those of routed that are selective, see Plan */
+    uint64_t selective[query_type_count];
+    uint64_t scanned[query_type_count];
+    double estimated[query_type_count];
+    uint64_t matched[query_type_count];
+    double absolute_error[query_type_count];
+};
+
+/* Estimates how many records match a query from histograms of C and T built
+ * at load time, and sends the selective ones to an exact scan:
+ *  - C is kept as an exact histogram, one count per distinct value
+ *  - T is an equi-width histogram of PLANNER_T_BUCKETS buckets over [min_T, max_T]
+ *  - by_T orders the records by T, so that a T window is scanned without touching the rest
+ * Scanning by C goes through the categories, when there are any. */
+struct Planner {
+    uint32_t length;
+    uint32_t C_length;
+    float32_t* C_values;
+    uint32_t* C_counts;
+    float32_t min_T;
+    float32_t max_T;
+    /* T_histogram[i] counts the records in buckets before i, PLANNER_T_BUCKETS + 1 entries */
+    uint32_t* T_histogram;
+    uint32_t* by_T;
+    const Categories* categories;
+    mutable PlannerCounters counters;
+
+    template <typename DB>
+    static Planner* New(const DB& db, const Categories* categories) {
+        Planner* planner = smalloc<Planner>(1, "planner", MEMORY_PLANNER);
+        planner->length = db.length;
+        planner->categories = categories;
+        planner->counters = {};
+
+        float32_t* C_sorted = smalloc<float32_t>(std::max<uint32_t>(db.length, 1), "planner C", MEMORY_PLANNER);
+        planner->by_T = smalloc<uint32_t>(std::max<uint32_t>(db.length, 1), "planner by_T", MEMORY_PLANNER);
+        for (uint32_t i = 0; i < db.length; i++) {
+            C_sorted[i] = view_of(db, i).C;
+            planner->by_T[i] = i;
+        }
+        auto by_value = [&db](const uint32_t& a, const uint32_t& b) {
+            const float32_t A = view_of(db, a).T;
+            const float32_t B = view_of(db, b).T;
+            if (A != B) {
+                return A < B;
+            } else {
+                return a < b;
+            }
+        };
+        #ifdef ENABLE_OMP
+        __gnu_parallel::sort(C_sorted, C_sorted + db.length);
+        __gnu_parallel::sort(planner->by_T, planner->by_T + db.length, by_value);
+        #else
+        std::sort(C_sorted, C_sorted + db.length);
+        std::sort(planner->by_T, planner->by_T + db.length, by_value);
+        #endif
+
+        uint32_t C_length = 0;
+        for (uint32_t i = 0; i < db.length; i++) {
+            if (i == 0 || C_sorted[i] != C_sorted[i - 1])
+                C_length++;
+        }
+        planner->C_length = C_length;
+        planner->C_values = smalloc<float32_t>(std::max<uint32_t>(C_length, 1), "planner C values", MEMORY_PLANNER);
+        planner->C_counts = smalloc<uint32_t>(std::max<uint32_t>(C_length, 1), "planner C counts", MEMORY_PLANNER);
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < db.length; i++) {
+            if (i == 0 || C_sorted[i] != C_sorted[i - 1]) {
+                if (i != 0)
+                    value++;
+                planner->C_values[value] = C_sorted[i];
+                planner->C_counts[value] = 0;
+            }
+            planner->C_counts[value]++;
+        }
+        sfree(C_sorted);
+
+        planner->min_T = db.length > 0 ? view_of(db, planner->by_T[0]).T : 0;
+        planner->max_T = db.length > 0 ? view_of(db, planner->by_T[db.length - 1]).T : 0;
+        planner->T_histogram = smalloc<uint32_t>(PLANNER_T_BUCKETS + 1, "planner T histogram", MEMORY_PLANNER);
+        std::fill(planner->T_histogram, planner->T_histogram + PLANNER_T_BUCKETS + 1, 0);
+        for (uint32_t i = 0; i < db.length; i++) {
+            planner->T_histogram[planner->bucket_of(view_of(db, i).T) + 1]++;
+        }
+        for (uint32_t i = 0; i < PLANNER_T_BUCKETS; i++) {
+            planner->T_histogram[i + 1] += planner->T_histogram[i];
+        }
+        return planner;
+    }
+
+    static void Free(Planner*& planner);
+
+    inline uint32_t bucket_of(const float32_t T) const {
+        if (!(max_T > min_T))
+            return 0;
+        const double position = (T - min_T) / (max_T - min_T) * PLANNER_T_BUCKETS;
+        return (uint32_t) std::clamp<double>(position, 0, PLANNER_T_BUCKETS - 1);
+    }
+
+    uint32_t count_C(const float32_t value) const;
+    double estimate_T(const float32_t l, const float32_t r) const;
+    Plan plan(const Query& query) const;
+
+    /* the records scanned by route are all considered, and the error of plan is recorded */
+    template <typename DB>
+    void scan(const DB& db, const Query& query, const Plan& plan, Scoreboard& scoreboard) const {
+        uint32_t matched = 0;
+        switch (plan.route) {
+            case ROUTE_SCAN_BY_C: {
+                const Category* category = categories->find(query.v);
+                if (category != nullptr)
+                    matched = categories->scan(db, *category, query, scoreboard);
+                break;
+            }
+            case ROUTE_SCAN_BY_T: {
+                auto T_below = [&db](const uint32_t& index, const float32_t value) {
+                    return view_of(db, index).T < value;
+                };
+                auto T_above = [&db](const float32_t value, const uint32_t& index) {
+                    return value < view_of(db, index).T;
+                };
+                const uint32_t* begin = by_T;
+                const uint32_t* end = by_T + length;
+                const uint32_t* first = std::lower_bound(begin, end, query.l, T_below);
+                const uint32_t* last = std::upper_bound(first, end, query.r, T_above);
+                matched = scan(db, query, first, last, scoreboard);
+                break;
+            }
+            default:
+                matched = scan(db, query, (const uint32_t*) nullptr, nullptr, scoreboard);
+                break;
+        }
+        record(query, plan, matched);
+    }
+
+    /* between first and last, or the whole database if first is nullptr */
+    template <typename DB>
+    uint32_t scan(const DB& db, const Query& query, const uint32_t* first, const uint32_t* last,
+                  Scoreboard& scoreboard) const {
+        uint32_t matched = 0;
+        const QueryBounds bounds = bounds_of(db, query);
+        const uint32_t count = first != nullptr ? last - first : length;
+        for (uint32_t i = 0; i < count; i++) {
+            const uint32_t index = first != nullptr ? first[i] : i;
+            const auto& record = view_of(db, index);
+            if (!check_if_elegible(query, record))
+                continue;
+            matched++;
+            if (scoreboard.full() && pruned(db, index, bounds, scoreboard.top().score)) {
+                PROFILE_COUNT(COUNTER_PRUNED_RECORDS);
+                continue;
+            }
+            if (scoreboard.full()) {
+                const score_t score = bounded_distance(query, record, scoreboard.top().score);
+                if (score < scoreboard.top().score)
+                    scoreboard.pushf(index, score);
+            } else {
+                scoreboard.add(index, fast_distance(query, record));
+            }
+        }
+        return matched;
+    }
+
+    void record(const Query& query, const Plan& plan) const;
+    void record(const Query& query, const Plan& plan, uint32_t matched) const;
+};
+
+void LogPlanner(const Planner& planner);
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef SIGMOD_PQ_HH
+#define SIGMOD_PQ_HH
+
+#include <sigmod/scoreboard.hh>
+#include <sigmod/columnar.hh>
+#include <sigmod/random.hh>
+#include <sigmod/memory.hh>
+#include <sigmod/flags.hh>
+#include <algorithm>
+
+static_assert(vector_num_dimension % PQ_SUBSPACES == 0, "PQ_SUBSPACES has to divide the dimensions");
+static_assert(PQ_CENTROIDS <= 256, "PQ codes are one byte per subspace");
+
+const uint32_t pq_subspace_dimensions = vector_num_dimension / PQ_SUBSPACES;
+
+/* Product quantization: the vectors are cut into PQ_SUBSPACES slices, each one
+ * replaced by the id of its nearest centroid among PQ_CENTROIDS trained by k-means
+ * on a sample of the database, so that a record takes PQ_SUBSPACES bytes.
+ *
+ * A query precomputes the distance from each of its slices to every centroid
+ * of that subspace, after which the (asymmetric) distance to a record is
+ * PQ_SUBSPACES table lookups. Searches scan every code, keep the best
+ * PQ_CANDIDATES that pass the filters, and rerank them with the exact distance
+ * over the database the engine is searched with. */
+struct PQ {
+    uint32_t length;
+    /* [subspace][centroid][dimension of the subspace] */
+    float32_t* codebooks;
+    /* [record][subspace] */
+    uint8_t* codes;
+
+    template <typename DB>
+    static PQ* New(const DB& db, uint64_t seed = 0) {
+        PQ* pq = smalloc<PQ>(1, "pq", MEMORY_QUANTIZED);
+        pq->length = db.length;
+        pq->codebooks = smalloc<float32_t>(PQ_SUBSPACES * PQ_CENTROIDS * pq_subspace_dimensions, "pq codebooks", MEMORY_QUANTIZED);
+        pq->codes = smalloc<uint8_t>(std::max<uint64_t>((uint64_t) db.length * PQ_SUBSPACES, 1), "pq codes", MEMORY_QUANTIZED);
+
+        /* an evenly strided sample, so that training doesn't depend on the order of the file */
+        const uint32_t sample_length = std::min<uint32_t>(db.length, PQ_TRAINING_LENGTH);
+        float32_t* sample = smalloc<float32_t>(std::max<uint64_t>((uint64_t) sample_length * vector_num_dimension, 1), "pq sample");
+        for (uint32_t i = 0; i < sample_length; i++) {
+            const uint32_t index = (uint32_t) ((uint64_t) i * db.length / sample_length);
+            std::copy(view_of(db, index).fields, view_of(db, index).fields + vector_num_dimension,
+                      sample + (uint64_t) i * vector_num_dimension);
+        }
+        pq->train(sample, sample_length, seed);
+        sfree(sample);
+
+        #ifdef ENABLE_OMP
+        #pragma omp parallel for schedule(static)
+        #endif
+        for (uint32_t i = 0; i < db.length; i++) {
+            pq->encode(view_of(db, i).fields, pq->codes + (uint64_t) i * PQ_SUBSPACES);
+        }
+        return pq;
+    }
+
+    static void Free(PQ*& pq);
+
+    /* k-means over each subspace of sample, PQ_TRAINING_ITERATIONS rounds of Lloyd's algorithm */
+    void train(const float32_t* sample, uint32_t sample_length, uint64_t seed);
+    void encode(const float32_t* vector, uint8_t* code) const;
+    /* table[subspace * PQ_CENTROIDS + centroid] := squared distance of the slice of vector from centroid */
+    void lookup_table(const float32_t* vector, float32_t* table) const;
+
+    inline const float32_t* centroid(const uint32_t subspace, const uint32_t id) const {
+        return codebooks + ((uint64_t) subspace * PQ_CENTROIDS + id) * pq_subspace_dimensions;
+    }
+
+    static inline float32_t distance(const float32_t* table, const uint8_t* code) {
+        float32_t sum = 0;
+        for (uint32_t m = 0; m < PQ_SUBSPACES; m++) {
+            sum += table[m * PQ_CENTROIDS + code[m]];
+        }
+        return sum;
+    }
+
+    template <typename DB, typename Board>
+    void search(const DB& db, const Query& query, Board& scoreboard) const {
+        thread_local float32_t table[PQ_SUBSPACES * PQ_CENTROIDS];
+        thread_local FixedScoreboard<PQ_CANDIDATES> candidates;
+        thread_local Candidate found[PQ_CANDIDATES];
+        lookup_table(query.fields, table);
+        for (uint32_t i = 0; i < length; i++) {
+            if (!check_if_elegible(query, view_of(db, i)))
+                continue;
+            candidates.push(i, distance(table, codes + (uint64_t) i * PQ_SUBSPACES));
+        }
+        const uint32_t count = candidates.drain(found);
+        for (uint32_t i = 0; i < count; i++) {
+            scoreboard.push(found[i].index, fast_distance(query, view_of(db, found[i].index)));
+        }
+    }
+};
+
+#endif
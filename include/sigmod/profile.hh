@@ -0,0 +1,92 @@
+#ifndef SIGMOD_PROFILE_HH
+#define SIGMOD_PROFILE_HH
+
+#include <sigmod/config.hh>
+#include <sigmod/flags.hh>
+#include <sigmod/query.hh>
+#include <algorithm>
+#include <atomic>
+#include <ostream>
+#include <string>
+
+/* What the search templates count with ENABLE_PROFILE */
+enum counter_t {
+    COUNTER_QUERIES = 0,
+    COUNTER_DISTANCES = 1,
+    COUNTER_NODES = 2,
+    COUNTER_LEAVES = 3,
+    COUNTER_INSERTIONS = 4,
+    COUNTER_PRUNED_SUBTREES = 5,
+    COUNTER_PRUNED_RECORDS = 6
+};
+
+const uint32_t counter_count = 7;
+
+/* query types, plus one for whatever is counted outside a query (e.g. the builds) */
+const uint32_t profile_type_count = query_type_count + 1;
+
+/* The counts of one thread, on cache lines of their own so that threads
+ * never write to the same line. Each thread registers its own the first time
+ * it counts anything, and they are only summed when the profile is read.
+ * Only the thread itself adds to its counts, so they are relaxed atomics
+ * for the readers' sake, loaded and stored without a locked instruction. */
+struct alignas(64) Profile {
+    std::atomic<uint64_t> counts[profile_type_count][counter_count];
+    /* perf_event_open descriptors of the thread, -1 if unavailable or once it has exited */
+    int cycles;
+    int llc_misses;
+    /* what the descriptors had counted when they were closed */
+    long long closed_cycles;
+    long long closed_llc_misses;
+};
+
+/* the counts of every thread, summed */
+struct ProfileTotals {
+    uint64_t counts[profile_type_count][counter_count];
+};
+
+Profile* RegisterProfile();
+
+inline thread_local Profile* SIGMOD_THREAD_PROFILE = nullptr;
+/* what is being counted on this thread, query_type_count outside of queries */
+inline thread_local uint32_t SIGMOD_PROFILE_TYPE = query_type_count;
+
+inline void Count(const counter_t counter, const uint64_t amount = 1) {
+    if (SIGMOD_THREAD_PROFILE == nullptr)
+        SIGMOD_THREAD_PROFILE = RegisterProfile();
+    std::atomic<uint64_t>& count = SIGMOD_THREAD_PROFILE->counts[SIGMOD_PROFILE_TYPE][counter];
+    count.store(count.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+/* attributes everything counted on this thread during its lifetime to query */
+struct ProfiledQuery {
+    inline ProfiledQuery(const Query& query) {
+        SIGMOD_PROFILE_TYPE = std::min<uint32_t>(query.query_type, query_type_count - 1);
+        Count(COUNTER_QUERIES);
+    }
+    inline ~ProfiledQuery() { SIGMOD_PROFILE_TYPE = query_type_count; }
+};
+
+/* The counting is decided where the templates are instantiated, so that it costs
+ * nothing without ENABLE_PROFILE */
+#ifdef ENABLE_PROFILE
+#define PROFILE_COUNT(...) Count(__VA_ARGS__)
+#define PROFILE_QUERY(query) const ProfiledQuery profiled_query(query)
+#else
+#define PROFILE_COUNT(...)
+#define PROFILE_QUERY(query)
+#endif
+
+ProfileTotals TotalProfile();
+void ResetProfile();
+
+/* Ends a phase, called by LogTime, with the memory allocated at its end and at its peak.
+ * With ENABLE_PERF_COUNTERS the cycles and LLC misses of the registered threads
+ * during the phase are recorded too. */
+void ProfilePhase(const std::string& name, double milliseconds);
+
+/* the phases, the totals by query type and the memory peaks, as a JSON object */
+void WriteProfile(std::ostream& output);
+void WriteProfile(const std::string& path);
+
+#endif
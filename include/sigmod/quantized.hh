@@ -0,0 +1,71 @@
+#ifndef SIGMOD_QUANTIZED_HH
+#define SIGMOD_QUANTIZED_HH
+
+#include <sigmod/columnar.hh>
+#include <sigmod/scoreboard.hh>
+
+/* every code row is padded with zeros up to a whole number of 64 byte lines,
+ * and minimum and step up to a multiple of 16 dimensions, as the kernels expect */
+const uint32_t quantized_stride = ((vector_num_dimension + vector_alignment - 1) / vector_alignment) * vector_alignment;
+const uint32_t quantized_dimensions = ((vector_num_dimension + 15) / 16) * 16;
+
+/* A copy of the vectors of a database with one uint8 code per dimension,
+ * a quarter of the bytes of the float32_t ones:
+ * dimension d decodes to minimum[d] + step[d] * code, with minimum and step
+ * spanning the range of d over the whole database.
+ * C and T are borrowed from the ColumnarDatabase it was built from. */
+struct QuantizedDatabase {
+    uint32_t length;
+    const float32_t* C;
+    const float32_t* T;
+    uint8_t* codes;
+    float32_t* minimum;
+    float32_t* step;
+};
+
+struct QuantizedView {
+    float32_t C;
+    float32_t T;
+    const uint8_t* codes;
+    const float32_t* minimum;
+    const float32_t* step;
+};
+
+QuantizedDatabase BuildQuantizedDatabase(const ColumnarDatabase& database);
+void FreeQuantizedDatabase(QuantizedDatabase& database);
+
+inline QuantizedView view_of(const QuantizedDatabase& database, const uint32_t index) {
+    return {
+        .C = database.C[index],
+        .T = database.T[index],
+        .codes = database.codes + (uint64_t) index * quantized_stride,
+        .minimum = database.minimum,
+        .step = database.step
+    };
+}
+
+/* found by argument dependent lookup from the search templates, in place of the float32_t ones */
+inline score_t fast_distance(const Query& query, const QuantizedView& record) {
+    PROFILE_COUNT(COUNTER_DISTANCES);
+    return SIGMOD_DISTANCE_KERNELS.quantized(query.fields, record.codes, record.minimum, record.step);
+}
+
+inline score_t bounded_distance(const Query& query, const QuantizedView& record, const score_t bound) {
+    PROFILE_COUNT(COUNTER_DISTANCES);
+    return SIGMOD_DISTANCE_KERNELS.bounded_quantized(query.fields, record.codes, record.minimum, record.step, bound);
+}
+
+inline const PCA* pca_of(const QuantizedDatabase&) {
+    return nullptr;
+}
+
+/* the bounds hold for the exact distances, not the quantized ones */
+inline QueryBounds bounds_of(const QuantizedDatabase&, const Query&) {
+    return {};
+}
+
+inline bool pruned(const QuantizedDatabase&, const uint32_t, const QueryBounds&, const score_t) {
+    return false;
+}
+
+#endif
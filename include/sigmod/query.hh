@@ -19,6 +19,8 @@ enum query_t {
     BY_C_AND_T = 3
 };
 
+const uint32_t query_type_count = 4;
+
 std::ostream& operator<<(std::ostream& out, const Query& query);
 
 #endif
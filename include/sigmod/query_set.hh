@@ -2,14 +2,18 @@
 #define SIGMOD_QUERY_SET_HH
 
 #include <sigmod/query.hh>
+#include <sigmod/mapping.hh>
 #include <string>
 
 struct QuerySet {
     uint32_t length;
     Query* queries;
+    /* set when queries points into a read-only file mapping */
+    Mapping mapping;
 };
 
 QuerySet ReadQuerySet(std::string input_path);
+QuerySet MapQuerySet(std::string input_path);
 void WriteQuerySet(QuerySet& query_set, std::string output_path);
 void FreeQuerySet(QuerySet& query_set);
 void StatsQuerySet(QuerySet& query_set);
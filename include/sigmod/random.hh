@@ -3,7 +3,59 @@
 
 #include <sigmod/config.hh>
 
-uint32_t RandomUINT32T(uint32_t min, uint32_t max);
-float32_t RandomFLOAT32T(float32_t min, float32_t max);
+uint64_t SplitMix64(uint64_t& state);
+
+/* xoshiro256** by Blackman and Vigna: 256 bits of state, period 2^256 - 1.
+ * Streams are split with jump(), which moves 2^128 steps ahead, so that
+ * Stream(seed, i) and Stream(seed, j) never overlap in practice. */
+struct Xoshiro256 {
+    uint64_t s[4];
+
+    /* the state is expanded from seed with splitmix64, as the authors recommend */
+    static Xoshiro256 Seeded(uint64_t seed);
+    /* the stream-th non-overlapping stream of seed, costs stream jumps */
+    static Xoshiro256 Stream(uint64_t seed, uint64_t stream);
+
+    static inline uint64_t rotl(const uint64_t x, const int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    inline uint64_t next() {
+        const uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    void jump();
+
+    /* uniform in [min, max), without modulo bias (Lemire's multiply and reject) */
+    inline uint32_t uniform(const uint32_t min, const uint32_t max) {
+        const uint32_t width = max - min;
+        uint64_t product = (next() >> 32) * width;
+        uint32_t low = (uint32_t) product;
+        if (low < width) {
+            const uint32_t threshold = -width % width;
+            while (low < threshold) {
+                product = (next() >> 32) * width;
+                low = (uint32_t) product;
+            }
+        }
+        return (uint32_t) (product >> 32) + min;
+    }
+
+    /* uniform in [min, max), with the 24 bits a float32_t mantissa holds */
+    inline float32_t uniform(const float32_t min, const float32_t max) {
+        return min + (max - min) * ((next() >> 40) * 0x1.0p-24f);
+    }
+
+    /* standard normal, by Box-Muller; the second value of the pair is thrown away */
+    float32_t normal();
+};
 
 #endif
@@ -0,0 +1,15 @@
+#ifndef SIGMOD_SCHEDULE_HH
+#define SIGMOD_SCHEDULE_HH
+
+#include <sigmod/query_set.hh>
+#include <sigmod/tree.hh>
+
+/* The order queries should be answered in, so that consecutive ones touch the same memory:
+ *  - grouped by query type first
+ *  - BY_C and BY_C_AND_T queries by C, then by l
+ *  - BY_T queries by l, then by r
+ *  - NORMAL queries by the leaf of tree they fall in, when there is a tree
+ * Ties keep the file order. The result has qs.length entries and is freed with sfree. */
+uint32_t* ScheduleQueries(const QuerySet& qs, const Tree* tree);
+
+#endif
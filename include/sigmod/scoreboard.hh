@@ -6,14 +6,14 @@
 #include <sigmod/debug.hh>
 #include <sigmod/record.hh>
 #include <sigmod/query.hh>
-#include <vector>
+#include <sigmod/distance.hh>
+#include <sigmod/profile.hh>
+#include <algorithm>
 #include <cmath>
 
 template <typename WFA, typename WFB>
 inline score_t distance(const WFA& query, const WFB& record) {
-    #ifdef TRACK_DISTANCE_COMPUTATIONS
-        SIGMOD_DISTANCE_COMPUTATIONS++;
-    #endif
+    PROFILE_COUNT(COUNTER_DISTANCES);
     score_t sum = 0;
     for (uint32_t i = 0; i < vector_num_dimension; i++) {
         score_t m = query.fields[i] - record.fields[i];
@@ -30,16 +30,47 @@ inline score_t distance(const WFA& query, const WFB& record) {
     #endif
 }
 
-inline bool check_if_elegible_by_T(const Query& query, const Record& record) {
+/* squared distance computed by the vectorized kernels, see distance.hh */
+template <typename WFA, typename WFB>
+inline score_t fast_distance(const WFA& query, const WFB& record) {
+    PROFILE_COUNT(COUNTER_DISTANCES);
+    return SIGMOD_DISTANCE_KERNELS.full(query.fields, record.fields);
+}
+
+/* like fast_distance, but gives up once it is sure to be above bound */
+template <typename WFA, typename WFB>
+inline score_t bounded_distance(const WFA& query, const WFB& record, const score_t bound) {
+    PROFILE_COUNT(COUNTER_DISTANCES);
+    return SIGMOD_DISTANCE_KERNELS.bounded(query.fields, record.fields, bound);
+}
+
+template <typename WithCT>
+inline bool check_if_elegible_by_T(const Query& query, const WithCT& record) {
     if ((uint32_t) query.query_type == BY_C || (uint32_t) query.query_type == NORMAL)
       return true;
     return (query.l <= record.T && query.r >= record.T);
 }
 
-inline bool elegible_by_T(const Query& query, const Record& record) {
+template <typename WithCT>
+inline bool elegible_by_T(const Query& query, const WithCT& record) {
     return (query.l <= record.T && query.r >= record.T);
 }
 
+template <typename WithCT>
+inline bool elegible_by_C(const Query& query, const WithCT& record) {
+    return query.v == record.C;
+}
+
+template <typename WithCT>
+inline bool check_if_elegible(const Query& query, const WithCT& record) {
+    switch ((uint32_t) query.query_type) {
+        case BY_C: return elegible_by_C(query, record);
+        case BY_T: return elegible_by_T(query, record);
+        case BY_C_AND_T: return elegible_by_C(query, record) && elegible_by_T(query, record);
+        default: return true;
+    }
+}
+
 struct Candidate {
     uint32_t index;
     score_t score;
@@ -48,61 +79,148 @@ struct Candidate {
 };
 
 /*
-* I think we can convert this vector to a Candidate& carray because
-* all insertions follow insertion sort and we don't have ever more than k_nearest_neighbors
-* across the sigmod program
+* Bounded max-heap of at most K candidates, stored inline so that it can live on the stack.
+* The furthest candidate sits at the root, so the current threshold is always board[0].
 */
-struct Scoreboard {
+template <uint32_t K>
+struct FixedScoreboard {
     private:
-        std::vector<Candidate> board = {};
+        Candidate board[K];
+        uint32_t length = 0;
+
+        inline void sift_up(uint32_t position) {
+            const Candidate candidate = board[position];
+            while (position > 0) {
+                const uint32_t parent = (position - 1) / 2;
+                if (board[parent].score >= candidate.score)
+                    break;
+                board[position] = board[parent];
+                position = parent;
+            }
+            board[position] = candidate;
+        }
+
+        inline void sift_down(uint32_t position, const uint32_t limit) {
+            const Candidate candidate = board[position];
+            while (true) {
+                uint32_t child = 2 * position + 1;
+                if (child >= limit)
+                    break;
+                if (child + 1 < limit && board[child + 1].score > board[child].score)
+                    child++;
+                if (board[child].score <= candidate.score)
+                    break;
+                board[position] = board[child];
+                position = child;
+            }
+            board[position] = candidate;
+        }
+
     public:
-        uint32_t size() const;
-        const Candidate& furthest() const;
-        const Candidate& nearest() const;
-        inline const Candidate& top() const {
-            return furthest();
-        };
-        inline const Candidate& bottom() const {
-            return nearest();
-        };
-        void pop();
-        void add(const uint32_t index, const score_t score);
-        void consider(const Candidate& candidate);
-        void update(const Scoreboard& input);
-        bool has(const uint32_t index) const;
-        bool empty() const;
-        bool full() const;
+        inline uint32_t size() const { return length; }
+        inline bool empty() const { return length == 0; }
+        inline bool full() const { return length == K; }
         inline bool not_full() const { return !full(); }
+        inline const Candidate& furthest() const { return board[0]; }
+        inline const Candidate& top() const { return furthest(); }
+        inline void clear() { length = 0; }
+
+        /* linear, the heap gives no order among the other candidates */
+        const Candidate& nearest() const {
+            uint32_t best = 0;
+            for (uint32_t i = 1; i < length; i++) {
+                if (board[i].score < board[best].score)
+                    best = i;
+            }
+            return board[best];
+        }
+        inline const Candidate& bottom() const { return nearest(); }
+
+        inline void pop() {
+            length--;
+            if (length > 0) {
+                board[0] = board[length];
+                sift_down(0, length);
+            }
+        }
+
+        /* assumes not full() */
+        inline void add(const uint32_t index, const score_t score) {
+            #ifdef SCOREBOARD_ALWAYS_CHECK_DUPLICATES
+            if (has(index))
+                return;
+            #endif
+            PROFILE_COUNT(COUNTER_INSERTIONS);
+            board[length] = Candidate(index, score);
+            sift_up(length++);
+        }
+
+        bool has(const uint32_t index) const {
+            for (uint32_t i = 0; i < length; i++) {
+                if (board[i].index == index)
+                    return true;
+            }
+            return false;
+        }
+
         inline void pushf(const uint32_t index, const score_t score) {
           // assumes score < furthest().score has been done
           if (full()) {
-              pop();
+              #ifdef SCOREBOARD_ALWAYS_CHECK_DUPLICATES
+              if (has(index))
+                  return;
+              #endif
+              PROFILE_COUNT(COUNTER_INSERTIONS);
+              board[0] = Candidate(index, score);
+              sift_down(0, length);
+          } else {
+              add(index, score);
           }
-          add(index, score);
         }
         inline void push(const uint32_t index, const score_t score) {
           if (full()) {
               if (score < top().score) {
-                  pop();
-                  add(index, score);
+                  pushf(index, score);
               }
           } else {
               add(index, score);
           }
         }
         inline void pushs(const uint32_t index, const score_t score) {
-          if (!has(index)) {
-              if (full()) {
-                  if (score < top().score) {
-                      pop();
-                      add(index, score);
-                  }
-              } else {
-                  add(index, score);
+          if (full()) {
+              if (score < top().score && !has(index)) {
+                  pushf(index, score);
               }
+          } else if (!has(index)) {
+              add(index, score);
           }
         }
-        void clear();
+        inline void consider(const Candidate& candidate) {
+            push(candidate.index, candidate.score);
+        }
+
+        /* combines another board (e.g. from another thread) into this one */
+        void merge(const FixedScoreboard& input) {
+            for (uint32_t i = 0; i < input.length; i++) {
+                if (full() && input.board[i].score >= top().score)
+                    continue;
+                push(input.board[i].index, input.board[i].score);
+            }
+        }
+
+        /* heapsorts in place, writes the candidates nearest first and leaves the board empty */
+        uint32_t drain(Candidate* output) {
+            const uint32_t count = length;
+            for (uint32_t last = count; last > 1; last--) {
+                std::swap(board[0], board[last - 1]);
+                sift_down(0, last - 1);
+            }
+            std::copy(board, board + count, output);
+            length = 0;
+            return count;
+        }
 };
 
+typedef FixedScoreboard<k_nearest_neighbors> Scoreboard;
+
 #endif
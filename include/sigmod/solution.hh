@@ -0,0 +1,22 @@
+#ifndef SIGMOD_SOLUTION_HH
+#define SIGMOD_SOLUTION_HH
+
+#include <sigmod/config.hh>
+#include <string>
+
+/* written in place of the neighbours a query doesn't have, when fewer than
+ * k_nearest_neighbors records pass its filters */
+const uint32_t missing_neighbor = UINT32_MAX;
+
+/* results holds k_nearest_neighbors record indices per query, in query order,
+ * nearest first and padded with missing_neighbor */
+struct Solution {
+    uint32_t length;
+    uint32_t* results;
+};
+
+Solution NewSolution(uint32_t length);
+void WriteSolution(const Solution& solution, std::string output_path);
+void FreeSolution(Solution& solution);
+
+#endif
@@ -0,0 +1,802 @@
+#ifndef SIGMOD_TREE_HH
+#define SIGMOD_TREE_HH
+
+#include <sigmod/config.hh>
+#include <sigmod/flags.hh>
+#include <sigmod/columnar.hh>
+#include <sigmod/scoreboard.hh>
+#include <sigmod/random.hh>
+#include <sigmod/mapping.hh>
+#include <sigmod/seek.hh>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <cmath>
+#ifdef ENABLE_OMP
+#include <omp.h>
+#endif
+
+/* records of the subtree are by_C[start, end) (equivalently by_T[start, end)).
+ * Children are allocated in pairs, so right is always left + 1; leaves have left = 0
+ * because the root is never anybody's child. */
+struct Node {
+    uint32_t start;
+    uint32_t end;
+    uint32_t left;
+    uint32_t hyperplane;
+
+    inline bool is_leaf() const { return left == 0; }
+    inline uint32_t right() const { return left + 1; }
+    inline uint32_t length() const { return end - start; }
+};
+
+/* What a subtree holds, so that filtered searches can skip the ones without matches:
+ * the range of T and a 128 bit hashed set of the C values. */
+struct Summary {
+    float32_t min_T;
+    float32_t max_T;
+    uint64_t C_bits[2];
+
+    static inline uint32_t bit_of(const float32_t C) {
+        uint32_t bits;
+        std::memcpy(&bits, &C, sizeof(float32_t));
+        return (bits * 0x9e3779b1u) >> 25;
+    }
+
+    static inline Summary Empty() {
+        return { INFINITY, -INFINITY, {0, 0} };
+    }
+
+    static inline Summary Merge(const Summary& a, const Summary& b) {
+        return {
+            std::min(a.min_T, b.min_T),
+            std::max(a.max_T, b.max_T),
+            {a.C_bits[0] | b.C_bits[0], a.C_bits[1] | b.C_bits[1]}
+        };
+    }
+
+    inline void add(const float32_t C, const float32_t T) {
+        const uint32_t bit = bit_of(C);
+        C_bits[bit / 64] |= (uint64_t) 1 << (bit % 64);
+        min_T = std::min(min_T, T);
+        max_T = std::max(max_T, T);
+    }
+
+    inline bool may_contain_C(const float32_t C) const {
+        const uint32_t bit = bit_of(C);
+        return (C_bits[bit / 64] >> (bit % 64)) & 1;
+    }
+
+    inline bool overlaps_T(const float32_t l, const float32_t r) const {
+        return l <= max_T && r >= min_T;
+    }
+
+    inline bool may_match(const Query& query) const {
+        switch ((uint32_t) query.query_type) {
+            case BY_C: return may_contain_C(query.v);
+            case BY_T: return overlaps_T(query.l, query.r);
+            case BY_C_AND_T: return may_contain_C(query.v) && overlaps_T(query.l, query.r);
+            default: return true;
+        }
+    }
+};
+
+/* What a search may still spend on a query, UINT32_MAX is as good as unlimited */
+struct SearchBudget {
+    uint32_t leaves;
+    uint32_t distances;
+
+    inline bool exhausted() const {
+        return leaves == 0 || distances == 0;
+    }
+};
+
+/* A subtree left behind by a best-first search: bound is a lower bound
+ * on the distance between the query and any record inside it */
+struct Branch {
+    float32_t bound;
+    uint32_t tree;
+    uint32_t node;
+};
+
+/* min-heap of the branches a best-first search has yet to explore */
+struct Frontier {
+    std::vector<Branch> heap;
+
+    static inline bool further(const Branch& a, const Branch& b) {
+        return a.bound > b.bound;
+    }
+
+    inline bool empty() const { return heap.empty(); }
+    inline uint32_t size() const { return heap.size(); }
+    inline void clear() { heap.clear(); }
+    inline const Branch& top() const { return heap.front(); }
+
+    inline void push(const Branch& branch) {
+        heap.push_back(branch);
+        std::push_heap(heap.begin(), heap.end(), further);
+    }
+
+    inline void pop() {
+        std::pop_heap(heap.begin(), heap.end(), further);
+        heap.pop_back();
+    }
+};
+
+/* Open addressing set of the record ids a search has already been through, e.g. so that
+ * the records a Forest reaches through several trees are only scored once. The table grows
+ * with what the searches visit, and is cleared in O(1) by bumping the stamp. */
+struct VisitedSet {
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> stamps;
+    uint32_t stamp = 0;
+    uint32_t length = 0;
+    uint32_t shift = 32;
+
+    inline uint32_t slot_of(const uint32_t index) const {
+        return (uint32_t) (index * 0x9e3779b1u) >> shift;
+    }
+
+    inline void clear() {
+        length = 0;
+        if (++stamp == 0) {
+            std::fill(stamps.begin(), stamps.end(), 0);
+            stamp = 1;
+        }
+    }
+
+    /* false if index was already there */
+    inline bool insert(const uint32_t index) {
+        if (2 * (length + 1) > indices.size())
+            grow();
+        const uint32_t mask = indices.size() - 1;
+        uint32_t slot = slot_of(index);
+        while (stamps[slot] == stamp) {
+            if (indices[slot] == index)
+                return false;
+            slot = (slot + 1) & mask;
+        }
+        stamps[slot] = stamp;
+        indices[slot] = index;
+        length++;
+        return true;
+    }
+
+    void grow() {
+        std::vector<uint32_t> old_indices(std::max<size_t>(1024, 2 * indices.size()));
+        std::vector<uint32_t> old_stamps(old_indices.size(), 0);
+        std::swap(indices, old_indices);
+        std::swap(stamps, old_stamps);
+        shift = 32 - __builtin_ctz(indices.size());
+        const uint32_t old_stamp = stamp;
+        stamp = 1;
+        length = 0;
+        for (uint32_t i = 0; i < old_indices.size(); i++) {
+            if (old_stamps[i] == old_stamp)
+                insert(old_indices[i]);
+        }
+    }
+};
+
+/* Random hyperplane tree stored in a handful of arenas:
+ *  - nodes, indexed by node id, the root is nodes[0], and their summaries
+ *  - hyperplanes, a matrix of vector_stride floats per internal node, plus their offsets
+ *  - by_C and by_T, the leaf index lists back to back, each leaf sorted by C and by T
+ * */
+struct Tree {
+    uint32_t seed;
+    uint32_t length;
+    uint32_t nodes_length;
+    uint32_t hyperplanes_length;
+    Node* nodes;
+    /* indexed by node id, like nodes */
+    Summary* summaries;
+    float32_t* hyperplanes;
+    float32_t* offsets;
+    uint32_t* by_C;
+    uint32_t* by_T;
+    /* set when the arenas point into a mapped index file, see MapTree */
+    Mapping mapping;
+
+    /* arenas are sized for the worst case allowed by TREE_MIN_SPLIT_FRACTION */
+    static Tree* Allocate(uint32_t length);
+    static void Free(Tree*& tree);
+    /* gives back the unused tail of the node and hyperplane arenas */
+    void shrink();
+    /* renumbers the records of the leaves, record i becomes inverse[i] */
+    void remap(const uint32_t* inverse);
+
+    inline bool may_match(const uint32_t node_id, const Query& query) const {
+        return summaries[node_id].may_match(query);
+    }
+
+    /* The part of a leaf a query has to look at, in the order it should be scanned:
+     * queries filtered by T only get the slice of by_T inside [query.l, query.r] */
+    template <typename DB>
+    inline const uint32_t* leaf_range(const DB& db, const Query& query, const Node& node,
+                                      uint32_t& first, uint32_t& last) const {
+        const uint32_t query_type = (uint32_t) query.query_type;
+        first = node.start;
+        last = node.end;
+        if ((query_type != BY_T && query_type != BY_C_AND_T) || node.start == node.end)
+            return by_C;
+
+        auto T_at = [this, &db](const uint32_t i) { return view_of(db, by_T[i]).T; };
+        /* SeekLow and SeekHigh may land next to the boundary, so they are fixed up */
+        first = SeekHigh(T_at, node.start, node.end, query.l);
+        while (first > node.start && T_at(first - 1) >= query.l)
+            first--;
+        while (first < node.end && T_at(first) < query.l)
+            first++;
+        last = SeekLow(T_at, node.start, node.end, query.r) + 1;
+        while (last < node.end && T_at(last) <= query.r)
+            last++;
+        while (last > first && T_at(last - 1) > query.r)
+            last--;
+        last = std::max(first, last);
+        return by_T;
+    }
+
+    inline const float32_t* hyperplane_of(const Node& node) const {
+        return hyperplanes + (uint64_t) node.hyperplane * vector_stride;
+    }
+
+    /* True := Left; False := Right */
+    template <typename WithFields>
+    inline bool sideof(const Node& node, const WithFields& vector) const {
+        return SIGMOD_DISTANCE_KERNELS.dot(hyperplane_of(node), vector.fields) >= offsets[node.hyperplane];
+    }
+
+    inline uint32_t new_children() {
+        uint32_t id;
+        #ifdef ENABLE_OMP
+        #pragma omp atomic capture
+        #endif
+        { id = nodes_length; nodes_length += 2; }
+        return id;
+    }
+
+    inline uint32_t new_hyperplane() {
+        uint32_t id;
+        #ifdef ENABLE_OMP
+        #pragma omp atomic capture
+        #endif
+        { id = hyperplanes_length; hyperplanes_length += 1; }
+        return id;
+    }
+
+    /* signed distance of vector from the hyperplane of node, positive on the left */
+    template <typename WithFields>
+    inline float32_t margin(const Node& node, const WithFields& vector) const {
+        return SIGMOD_DISTANCE_KERNELS.dot(hyperplane_of(node), vector.fields) - offsets[node.hyperplane];
+    }
+
+    /* the bisector of a and b: a falls on the left, b on the right.
+     * The normal is stored with unit norm, so that margins are actual distances. */
+    template <typename WFA, typename WFB>
+    void bisect(const uint32_t hyperplane, const WFA& a, const WFB& b) {
+        float32_t* fields = hyperplanes + (uint64_t) hyperplane * vector_stride;
+        float32_t offset = 0.0;
+        float32_t norm = 0.0;
+        for (uint32_t i = 0; i < vector_num_dimension; i++) {
+            fields[i] = a.fields[i] - b.fields[i];
+            offset += fields[i] * (a.fields[i] + b.fields[i]) / 2;
+            norm += fields[i] * fields[i];
+        }
+        norm = std::sqrt(norm);
+        if (norm > 0) {
+            for (uint32_t i = 0; i < vector_num_dimension; i++) {
+                fields[i] /= norm;
+            }
+            offset /= norm;
+        }
+        for (uint32_t i = vector_num_dimension; i < vector_stride; i++) {
+            fields[i] = 0.0;
+        }
+        offsets[hyperplane] = offset;
+    }
+
+    /* the hyperplane normal to direction (of unit norm) half way between a and b,
+     * a falls on the left unless both project to the same point */
+    template <typename WFA, typename WFB>
+    void split_along(const uint32_t hyperplane, const float32_t* direction, const WFA& a, const WFB& b) {
+        float32_t* fields = hyperplanes + (uint64_t) hyperplane * vector_stride;
+        const float32_t A = SIGMOD_DISTANCE_KERNELS.dot(direction, a.fields);
+        const float32_t B = SIGMOD_DISTANCE_KERNELS.dot(direction, b.fields);
+        const float32_t sign = A >= B ? 1 : -1;
+        for (uint32_t i = 0; i < vector_num_dimension; i++) {
+            fields[i] = sign * direction[i];
+        }
+        for (uint32_t i = vector_num_dimension; i < vector_stride; i++) {
+            fields[i] = 0.0;
+        }
+        offsets[hyperplane] = sign * (A + B) / 2;
+    }
+
+    /* the leaf vector falls in, following its side of every split */
+    template <typename WithFields>
+    inline uint32_t locate(const WithFields& vector) const {
+        uint32_t node_id = 0;
+        while (!nodes[node_id].is_leaf()) {
+            const Node& node = nodes[node_id];
+            node_id = sideof(node, vector) ? node.left : node.right();
+        }
+        return node_id;
+    }
+
+    /* sides[i] := sideof(indices[i]) for a whole batch of records */
+    template <typename DB>
+    void sidesof(const DB& db, const Node& node, const uint32_t* indices, uint32_t length, uint8_t* sides) const {
+        for (uint32_t i = 0; i < length; i++) {
+            if (i + 1 < length)
+                __builtin_prefetch(view_of(db, indices[i + 1]).fields);
+            sides[i] = sideof(node, view_of(db, indices[i]));
+        }
+    }
+
+    template <typename DB>
+    void leaf(const DB& db, const uint32_t node_id) {
+        const Node& node = nodes[node_id];
+        std::sort(by_C + node.start, by_C + node.end, [&db](const uint32_t& a, const uint32_t& b) {
+            const float32_t A = view_of(db, a).C;
+            const float32_t B = view_of(db, b).C;
+            if (A != B) {
+                return A < B;
+            } else {
+                return a < b;
+            }
+        });
+
+        std::copy(by_C + node.start, by_C + node.end, by_T + node.start);
+        std::sort(by_T + node.start, by_T + node.end, [&db](const uint32_t& a, const uint32_t& b) {
+            const float32_t A = view_of(db, a).T;
+            const float32_t B = view_of(db, b).T;
+            if (A != B) {
+                return A < B;
+            } else {
+                return a < b;
+            }
+        });
+
+        Summary summary = Summary::Empty();
+        for (uint32_t i = node.start; i < node.end; i++) {
+            summary.add(view_of(db, by_C[i]).C, view_of(db, by_C[i]).T);
+        }
+        summaries[node_id] = summary;
+    }
+
+    /* Moves the records of by_C[start, end) on the left of node first and returns
+     * where the right ones begin. by_T[start, end) is the scratch, which is free
+     * since leaves only fill it once their range is final. */
+    template <typename DB>
+    uint32_t partition(const DB& db, const Node& node, const uint32_t start, const uint32_t end) {
+        const uint32_t length = end - start;
+        if (length < PARALLEL_PARTITION_LENGTH) {
+            uint8_t* sides = (uint8_t*) (by_T + start);
+            sidesof(db, node, by_C + start, length, sides);
+            uint32_t i = 0;
+            uint32_t j = length;
+            while(i < j) {
+                if (sides[i]) {
+                    i++;
+                } else {
+                    j--;
+                    std::swap(by_C[start + i], by_C[start + j]);
+                    std::swap(sides[i], sides[j]);
+                }
+            }
+            return start + i;
+        }
+
+        /* each chunk counts its left records, and the prefix sums of the counts
+         * tell every chunk where to scatter its records in by_T */
+        const uint32_t chunks = (length + PARTITION_GRAIN_SIZE - 1) / PARTITION_GRAIN_SIZE;
+        std::vector<uint8_t> sides_buffer(length);
+        std::vector<uint32_t> lefts_buffer(chunks + 1, 0);
+        uint8_t* sides = sides_buffer.data();
+        uint32_t* lefts = lefts_buffer.data();
+        #ifdef ENABLE_OMP
+        #pragma omp taskloop
+        #endif
+        for (uint32_t chunk = 0; chunk < chunks; chunk++) {
+            const uint32_t first = chunk * PARTITION_GRAIN_SIZE;
+            const uint32_t chunk_length = std::min<uint32_t>(PARTITION_GRAIN_SIZE, length - first);
+            sidesof(db, node, by_C + start + first, chunk_length, sides + first);
+            lefts[chunk + 1] = std::count(sides + first, sides + first + chunk_length, 1);
+        }
+        for (uint32_t chunk = 0; chunk < chunks; chunk++) {
+            lefts[chunk + 1] += lefts[chunk];
+        }
+
+        const uint32_t middle = start + lefts[chunks];
+        #ifdef ENABLE_OMP
+        #pragma omp taskloop
+        #endif
+        for (uint32_t chunk = 0; chunk < chunks; chunk++) {
+            const uint32_t first = chunk * PARTITION_GRAIN_SIZE;
+            const uint32_t chunk_length = std::min<uint32_t>(PARTITION_GRAIN_SIZE, length - first);
+            uint32_t left = start + lefts[chunk];
+            uint32_t right = middle + first - lefts[chunk];
+            for (uint32_t i = first; i < first + chunk_length; i++) {
+                if (sides[i]) {
+                    by_T[left++] = by_C[start + i];
+                } else {
+                    by_T[right++] = by_C[start + i];
+                }
+            }
+        }
+        #ifdef ENABLE_OMP
+        #pragma omp taskloop
+        #endif
+        for (uint32_t chunk = 0; chunk < chunks; chunk++) {
+            const uint32_t first = start + chunk * PARTITION_GRAIN_SIZE;
+            std::copy(by_T + first, by_T + std::min<uint32_t>(first + PARTITION_GRAIN_SIZE, end), by_C + first);
+        }
+        return middle;
+    }
+
+    /* Splits by_C[start, end) in halves by their projection on the hyperplane of node,
+     * and moves its offset between them so that sideof still agrees with the split.
+     * Only records projecting exactly onto the offset may end up on the other side. */
+    template <typename DB>
+    uint32_t split_at_median(const DB& db, const Node& node, const uint32_t start, const uint32_t end) {
+        const float32_t* hyperplane = hyperplane_of(node);
+        std::vector<std::pair<float32_t, uint32_t>> projections(end - start);
+        float32_t lowest = INFINITY;
+        float32_t highest = -INFINITY;
+        for (uint32_t i = start; i < end; i++) {
+            projections[i - start] = { SIGMOD_DISTANCE_KERNELS.dot(hyperplane, view_of(db, by_C[i]).fields), by_C[i] };
+            lowest = std::min(lowest, projections[i - start].first);
+            highest = std::max(highest, projections[i - start].first);
+        }
+
+        /* pivots with identical vectors leave a null normal, which projects everything
+         * onto 0: bisect the first record and the furthest one from it instead */
+        if (lowest == highest) {
+            uint32_t furthest = by_C[start];
+            score_t furthest_distance = 0;
+            for (uint32_t i = start; i < end; i++) {
+                const score_t d = distance(view_of(db, by_C[start]), view_of(db, by_C[i]));
+                if (d > furthest_distance) {
+                    furthest = by_C[i];
+                    furthest_distance = d;
+                }
+            }
+            bisect(node.hyperplane, view_of(db, by_C[start]), view_of(db, furthest));
+            for (auto& projection : projections) {
+                projection.first = SIGMOD_DISTANCE_KERNELS.dot(hyperplane, view_of(db, projection.second).fields);
+            }
+        }
+
+        /* the left side is the one projecting further along the normal */
+        const uint32_t half = (end - start) / 2;
+        const auto further = [](const std::pair<float32_t, uint32_t>& a, const std::pair<float32_t, uint32_t>& b) {
+            return a > b;
+        };
+        std::nth_element(projections.begin(), projections.begin() + half, projections.end(), further);
+        const float32_t lowest_left = std::max_element(projections.begin(), projections.begin() + half, further)->first;
+        const float32_t highest_right = projections[half].first;
+        offsets[node.hyperplane] = lowest_left > highest_right ? (lowest_left + highest_right) / 2 : highest_right;
+
+        for (uint32_t i = start; i < end; i++) {
+            by_C[i] = projections[i - start].second;
+        }
+        return start + half;
+    }
+
+    /* by_C is the working index while building, each call only touches
+     * [node.start, node.end) of it and of the by_T scratch */
+    template <typename DB>
+    void build(const DB& db, uint32_t node_id) {
+        Node& node = nodes[node_id];
+        const uint32_t start = node.start;
+        const uint32_t end = node.end;
+        const uint32_t length = node.length();
+        node.left = 0;
+
+        if (length <= TREE_LEAF_LENGTH) {
+            leaf(db, node_id);
+            return;
+        }
+
+        /* pivots only depend on the seed and the range, whatever the order tasks run in;
+         * the three are chained through splitmix64 so that distinct ranges get unrelated streams */
+        uint64_t key = seed;
+        key = SplitMix64(key) ^ start;
+        key = SplitMix64(key) ^ end;
+        Xoshiro256 generator = Xoshiro256::Seeded(key);
+        uint32_t middle = start;
+        node.hyperplane = new_hyperplane();
+        for (uint32_t attempt = 0; attempt < TREE_SPLIT_ATTEMPTS; attempt++) {
+            uint32_t x = by_C[generator.uniform(start, end)];
+            uint32_t y = by_C[generator.uniform(start, end)];
+            while(x == y)
+                y = by_C[generator.uniform(start, end)];
+
+            #ifdef ENABLE_PCA_SPLITS
+            const PCA* pca = pca_of(db);
+            if (pca != nullptr) {
+                split_along(node.hyperplane, pca->component(generator.uniform(0u, PCA_COMPONENTS)), view_of(db, x), view_of(db, y));
+            } else {
+                bisect(node.hyperplane, view_of(db, x), view_of(db, y));
+            }
+            #else
+            bisect(node.hyperplane, view_of(db, x), view_of(db, y));
+            #endif
+
+            middle = partition(db, node, start, end);
+            if (std::min(middle - start, end - middle) >= length / TREE_MIN_SPLIT_FRACTION)
+                break;
+        }
+
+        /* unlucky pivots (e.g. identical vectors): split at the median to bound the depth */
+        if (std::min(middle - start, end - middle) < length / TREE_MIN_SPLIT_FRACTION) {
+            middle = split_at_median(db, node, start, end);
+        }
+
+        const uint32_t left = new_children();
+        nodes[left] = { start, middle, 0, 0 };
+        nodes[left + 1] = { middle, end, 0, 0 };
+        node.left = left;
+
+        if (length >= PARALLEL_BUILD_LENGTH) {
+            #ifdef ENABLE_OMP
+            #pragma omp task shared(db) firstprivate(left)
+            #endif
+            build(db, left);
+            build(db, left + 1);
+            #ifdef ENABLE_OMP
+            #pragma omp taskwait
+            #endif
+        } else {
+            build(db, left);
+            build(db, left + 1);
+        }
+        summaries[node_id] = Summary::Merge(summaries[left], summaries[left + 1]);
+    }
+
+    /* a tree over the records in indices only, they keep their ids in the database */
+    template <typename DB>
+    static Tree* New(const DB& db, const uint32_t* indices, uint32_t length, uint32_t seed = 0) {
+        Tree* tree = Allocate(length);
+        tree->seed = seed;
+        std::copy(indices, indices + length, tree->by_C);
+        tree->nodes[0] = { 0, length, 0, 0 };
+        tree->nodes_length = 1;
+        #ifdef ENABLE_OMP
+        /* when called from a parallel region the build tasks join its team */
+        if (omp_in_parallel()) {
+            tree->build(db, 0);
+        } else {
+            #pragma omp parallel
+            #pragma omp single
+            tree->build(db, 0);
+        }
+        #else
+        tree->build(db, 0);
+        #endif
+        tree->shrink();
+        return tree;
+    }
+
+    template <typename DB>
+    static Tree* New(const DB& db, uint32_t seed = 0) {
+        Tree* tree = Allocate(db.length);
+        tree->seed = seed;
+        for (uint32_t i = 0; i < db.length; i++) {
+            tree->by_C[i] = i;
+        }
+        tree->nodes[0] = { 0, db.length, 0, 0 };
+        tree->nodes_length = 1;
+        #ifdef ENABLE_OMP
+        #pragma omp parallel
+        #pragma omp single
+        #endif
+        tree->build(db, 0);
+        tree->shrink();
+        return tree;
+    }
+
+    /* the original depth first search, it only backtracks while the scoreboard isn't full */
+    template <typename DB, typename Board>
+    void search(const DB& db, const Query& query, Board& scoreboard, uint32_t node_id) const {
+        const Node& node = nodes[node_id];
+        PROFILE_COUNT(COUNTER_NODES);
+        if (!may_match(node_id, query)) {
+            PROFILE_COUNT(COUNTER_PRUNED_SUBTREES);
+            return;
+        }
+        if (node.is_leaf()) {
+            PROFILE_COUNT(COUNTER_LEAVES);
+            uint32_t first, last;
+            const uint32_t* order = leaf_range(db, query, node, first, last);
+            for (uint32_t i = first; i < last; i++) {
+                const uint32_t index = order[i];
+                const auto& record = view_of(db, index);
+                if (!check_if_elegible(query, record))
+                    continue;
+                if (scoreboard.full()) {
+                    const score_t score = bounded_distance(query, record, scoreboard.top().score);
+                    if (score < scoreboard.top().score)
+                        scoreboard.pushf(index, score);
+                } else {
+                    scoreboard.add(index, fast_distance(query, record));
+                }
+            }
+        } else if (sideof(node, query)) {
+            search(db, query, scoreboard, node.left);
+            if (scoreboard.not_full()) {
+                search(db, query, scoreboard, node.right());
+            }
+        } else {
+            search(db, query, scoreboard, node.right());
+            if (scoreboard.not_full()) {
+                search(db, query, scoreboard, node.left);
+            }
+        }
+    }
+
+    /* Nearest side first, backtracking into the far sides for as long as the budget lasts.
+     * The scoreboard may already hold candidates found elsewhere (e.g. by other trees of a
+     * Forest), so records in visited are skipped and those scored are added to it.
+     * Returns false once the budget is exhausted. */
+    template <typename DB, typename Board>
+    bool search(const DB& db, const Query& query, Board& scoreboard, SearchBudget& budget, VisitedSet& visited) const {
+        return search(db, query, bounds_of(db, query), scoreboard, budget, visited, 0);
+    }
+
+    template <typename DB, typename Board>
+    bool search(const DB& db, const Query& query, const QueryBounds& bounds, Board& scoreboard,
+                SearchBudget& budget, VisitedSet& visited, uint32_t node_id) const {
+        const Node& node = nodes[node_id];
+        PROFILE_COUNT(COUNTER_NODES);
+        if (!may_match(node_id, query)) {
+            PROFILE_COUNT(COUNTER_PRUNED_SUBTREES);
+            return true;
+        }
+        if (node.is_leaf()) {
+            return scan(db, query, bounds, scoreboard, budget, visited, node);
+        }
+        const bool left_first = sideof(node, query);
+        return search(db, query, bounds, scoreboard, budget, visited, left_first ? node.left : node.right())
+            && search(db, query, bounds, scoreboard, budget, visited, left_first ? node.right() : node.left);
+    }
+
+    /* the leaf part of the budgeted search, bounds are those of query */
+    template <typename DB, typename Board>
+    bool scan(const DB& db, const Query& query, const QueryBounds& bounds, Board& scoreboard,
+              SearchBudget& budget, VisitedSet& visited, const Node& node) const {
+        if (budget.exhausted())
+            return false;
+        budget.leaves--;
+        PROFILE_COUNT(COUNTER_LEAVES);
+        uint32_t first, last;
+        const uint32_t* order = leaf_range(db, query, node, first, last);
+        for (uint32_t i = first; i < last; i++) {
+            const uint32_t index = order[i];
+            const auto& record = view_of(db, index);
+            if (!check_if_elegible(query, record))
+                continue;
+            if (scoreboard.full() && pruned(db, index, bounds, scoreboard.top().score)) {
+                PROFILE_COUNT(COUNTER_PRUNED_RECORDS);
+                continue;
+            }
+            if (budget.distances == 0)
+                return false;
+            /* whatever was scored once either made it to the scoreboard or never will */
+            if (!visited.insert(index))
+                continue;
+            budget.distances--;
+            if (scoreboard.full()) {
+                const score_t score = bounded_distance(query, record, scoreboard.top().score);
+                if (score < scoreboard.top().score)
+                    scoreboard.pushf(index, score);
+            } else {
+                scoreboard.add(index, fast_distance(query, record));
+            }
+        }
+        return !budget.exhausted();
+    }
+
+    /* Follows the query down to a leaf, leaving the far side of every split in the frontier.
+     * Subtrees that can't match the filters are never entered nor left behind, so this
+     * returns UINT32_MAX if no leaf below branch can match. */
+    uint32_t descend(const Query& query, Frontier& frontier, const Branch& branch) const {
+        uint32_t node_id = branch.node;
+        float32_t bound = branch.bound;
+        while (!nodes[node_id].is_leaf()) {
+            const Node& node = nodes[node_id];
+            PROFILE_COUNT(COUNTER_NODES);
+            const float32_t distance_to_split = margin(node, query);
+            const uint32_t near = distance_to_split >= 0 ? node.left : node.right();
+            const uint32_t far = distance_to_split >= 0 ? node.right() : node.left;
+            const float32_t far_bound = std::max(bound, std::fabs(distance_to_split));
+            const bool near_matches = may_match(near, query);
+            const bool far_matches = may_match(far, query);
+            if (near_matches && far_matches) {
+                frontier.push({ far_bound, branch.tree, far });
+                node_id = near;
+            } else if (near_matches) {
+                PROFILE_COUNT(COUNTER_PRUNED_SUBTREES);
+                node_id = near;
+            } else if (far_matches) {
+                PROFILE_COUNT(COUNTER_PRUNED_SUBTREES);
+                node_id = far;
+                bound = far_bound;
+            } else {
+                PROFILE_COUNT(COUNTER_PRUNED_SUBTREES, 2);
+                return UINT32_MAX;
+            }
+        }
+        return node_id;
+    }
+
+    template <typename DB, typename Board>
+    void search(const DB& db, const Query& query, Board& scoreboard) const;
+};
+
+/* Explores the leaves of all the trees in order of their distance from the query,
+ * as estimated by the hyperplane margins. Stops when the budget is exhausted or when
+ * no branch left can hold anything nearer than the furthest candidate. */
+template <typename DB, typename Board>
+void SearchBestFirst(const DB& db, const Tree* const* trees, uint32_t length,
+                     const Query& query, Board& scoreboard, SearchBudget budget) {
+    thread_local Frontier frontier;
+    thread_local VisitedSet visited;
+    frontier.clear();
+    visited.clear();
+    const QueryBounds bounds = bounds_of(db, query);
+    for (uint32_t i = 0; i < length; i++) {
+        if (trees[i]->may_match(0, query))
+            frontier.push({ 0.0, i, 0 });
+    }
+
+    while (!frontier.empty() && !budget.exhausted()) {
+        const Branch branch = frontier.top();
+        frontier.pop();
+        if (scoreboard.full() && (score_t) branch.bound * branch.bound >= scoreboard.top().score) {
+            PROFILE_COUNT(COUNTER_PRUNED_SUBTREES, 1 + frontier.size());
+            break;
+        }
+        const Tree* tree = trees[branch.tree];
+        const uint32_t leaf = tree->descend(query, frontier, branch);
+        if (leaf == UINT32_MAX)
+            continue;
+        tree->scan(db, query, bounds, scoreboard, budget, visited, tree->nodes[leaf]);
+    }
+}
+
+template <typename DB, typename Board>
+void Tree::search(const DB& db, const Query& query, Board& scoreboard) const {
+    #ifdef ENABLE_BEST_FIRST
+    const Tree* self = this;
+    SearchBestFirst(db, &self, 1, query, scoreboard, { SEARCH_LEAF_BUDGET, SEARCH_DISTANCE_BUDGET });
+    #else
+    search(db, query, scoreboard, 0);
+    #endif
+}
+
+/* Index files start with a TreeFileHeader, followed by the arenas in the order
+ * nodes, summaries, hyperplanes, offsets, by_C, by_T, each one starting on a 64 byte boundary,
+ * so that a mapped file can be searched as it is. */
+const char tree_file_magic[8] = {'S', 'I', 'G', 'T', 'R', 'E', 'E', '\0'};
+const uint32_t tree_file_version = 4;
+
+struct TreeFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t vector_stride;
+    /* see ChecksumDatabase, detects indexes built over some other data */
+    uint64_t checksum;
+    uint32_t length;
+    uint32_t nodes_length;
+    uint32_t hyperplanes_length;
+    uint32_t seed;
+};
+
+void WriteTree(const Tree& tree, uint64_t checksum, std::string output_path);
+/* nullptr if the file is missing, from another version, or built over another database or seed */
+Tree* MapTree(std::string input_path, uint64_t checksum, uint32_t length, uint32_t seed = 0);
+
+#endif
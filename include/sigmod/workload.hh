@@ -0,0 +1,286 @@
+#ifndef SIGMOD_WORKLOAD_HH
+#define SIGMOD_WORKLOAD_HH
+
+#include <sigmod/query_set.hh>
+#include <sigmod/solution.hh>
+#include <sigmod/scoreboard.hh>
+#include <sigmod/tree.hh>
+#include <sigmod/forest.hh>
+#include <sigmod/categories.hh>
+#include <sigmod/planner.hh>
+#include <sigmod/exact.hh>
+#include <sigmod/quantized.hh>
+#include <sigmod/pq.hh>
+#include <sigmod/graph.hh>
+#include <sigmod/flags.hh>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/* What answers the queries the planner and the categories leave, as chosen by the flags */
+#if defined(ENABLE_PQ_ENGINE)
+typedef PQ Engine;
+#elif defined(ENABLE_FOREST)
+typedef Forest Engine;
+#else
+typedef Tree Engine;
+#endif
+
+/* empties the scoreboard into output, nearest first; missing neighbours are written
+ * as missing_neighbor. With ids, record i is written out as ids[i], see LayoutByLeaves */
+inline void Flush(Scoreboard& scoreboard, uint32_t* output, const uint32_t* ids = nullptr) {
+    Candidate candidates[k_nearest_neighbors];
+    const uint32_t count = scoreboard.drain(candidates);
+    for (uint32_t rank = 0; rank < k_nearest_neighbors; rank++) {
+        if (rank >= count) {
+            output[rank] = missing_neighbor;
+        } else {
+            const uint32_t index = candidates[rank].index;
+            output[rank] = ids != nullptr ? ids[index] : index;
+        }
+    }
+}
+
+/* looks for a saved tree first, and saves the one it builds otherwise */
+template <typename DB>
+Tree* LoadTree(const DB& db, uint64_t checksum, std::string path, uint32_t seed) {
+    Tree* tree = MapTree(path, checksum, db.length, seed);
+    if (tree != nullptr) {
+        LogTime("Loaded Tree " + path);
+    } else {
+        tree = Tree::New(db, seed);
+        LogTime("Built Tree");
+        WriteTree(*tree, checksum, path);
+        LogTime("Saved Tree " + path);
+    }
+    return tree;
+}
+
+/* path and checksum are only used with ENABLE_PERSISTENT_INDEX, to find the saved trees */
+template <typename DB>
+Engine* LoadEngine(const DB& db, uint64_t checksum, std::string path) {
+    #if defined(ENABLE_PQ_ENGINE)
+    (void) checksum;
+    (void) path;
+    PQ* pq = PQ::New(db);
+    LogTime("Built PQ");
+    return pq;
+    #elif defined(ENABLE_FOREST)
+    const SearchBudget budget = { .leaves = SEARCH_LEAF_BUDGET, .distances = SEARCH_DISTANCE_BUDGET };
+    #ifdef ENABLE_PERSISTENT_INDEX
+    Tree** trees = smalloc<Tree*>(FOREST_LENGTH, "forest trees", MEMORY_TREE_NODES);
+    for (uint32_t i = 0; i < FOREST_LENGTH; i++) {
+        trees[i] = LoadTree(db, checksum, path + "." + std::to_string(i), i);
+    }
+    return Forest::From(trees, FOREST_LENGTH, budget);
+    #else
+    (void) checksum;
+    (void) path;
+    Forest* forest = Forest::New(db, FOREST_LENGTH, budget);
+    LogTime("Built Forest");
+    return forest;
+    #endif
+    #else
+    #ifdef ENABLE_PERSISTENT_INDEX
+    return LoadTree(db, checksum, path, 0);
+    #else
+    (void) checksum;
+    (void) path;
+    Tree* tree = Tree::New(db);
+    LogTime("Built Tree");
+    return tree;
+    #endif
+    #endif
+}
+
+inline void FreeEngine(Engine*& engine) {
+    Engine::Free(engine);
+}
+
+/* the trees of the engine, none for PQ */
+inline std::vector<const Tree*> EngineTrees(const Engine* engine) {
+    #if defined(ENABLE_PQ_ENGINE)
+    (void) engine;
+    return {};
+    #elif defined(ENABLE_FOREST)
+    return std::vector<const Tree*>(engine->trees, engine->trees + engine->length);
+    #else
+    return { engine };
+    #endif
+}
+
+/* the tree queries are scheduled by, if any */
+inline const Tree* FirstTree(const Engine* engine) {
+    const std::vector<const Tree*> trees = EngineTrees(engine);
+    return trees.empty() ? nullptr : trees[0];
+}
+
+/* Moves the records of db into the leaf order of the first tree of engine, so that
+ * its leaves are contiguous runs of vectors scanned front to back, and renumbers the
+ * records of every tree to match. Everything else has to be built afterwards.
+ * Returns the original id of every record, nullptr if the engine has no trees. */
+inline uint32_t* LayoutByLeaves(ColumnarDatabase& db, Engine* engine) {
+    #if defined(ENABLE_PQ_ENGINE)
+    (void) db;
+    (void) engine;
+    return nullptr;
+    #else
+    #if defined(ENABLE_FOREST)
+    Tree** trees = engine->trees;
+    const uint32_t length = engine->length;
+    #else
+    Tree** trees = &engine;
+    const uint32_t length = 1;
+    #endif
+    if (length == 0)
+        return nullptr;
+    /* the leaves partition by_C in order, so by_C is the new order of the records */
+    uint32_t* ids = smalloc<uint32_t>(std::max<uint32_t>(db.length, 1), "layout ids", MEMORY_DATABASE);
+    uint32_t* inverse = smalloc<uint32_t>(std::max<uint32_t>(db.length, 1), "layout inverse");
+    std::copy(trees[0]->by_C, trees[0]->by_C + db.length, ids);
+    for (uint32_t i = 0; i < db.length; i++) {
+        inverse[ids[i]] = i;
+    }
+    PermuteColumnarDatabase(db, ids);
+    for (uint32_t t = 0; t < length; t++) {
+        trees[t]->remap(inverse);
+    }
+    sfree(inverse);
+    return ids;
+    #endif
+}
+
+/* What searches the queries the categories leave, chosen at runtime by name:
+ * "tree" is the Engine of the flags, "graph" a Graph built over its trees */
+inline bool UseGraph(const std::string& name) {
+    if (name != "tree" && name != "graph")
+        Panic("unknown engine " + name + ", expected tree or graph");
+    return name == "graph";
+}
+
+template <typename DB>
+Graph* BuildGraph(const DB& db, const Engine* engine) {
+    const std::vector<const Tree*> trees = EngineTrees(engine);
+    if (trees.empty())
+        Panic("the graph is built from the trees of the engine, which has none");
+    Graph* graph = Graph::New(db, trees.data(), trees.size());
+    LogTime("Built Graph");
+    return graph;
+}
+
+/* What queries are answered with, all but engine may be nullptr:
+ *  - without categories, C-filtered queries go to the engine too
+ *  - without planner, no query is scanned exhaustively
+ *  - with quantized, the engine searches the quantized vectors and its candidates are reranked
+ *  - with graph, the graph searches the exact vectors instead of the engine
+ *  - with ids, the records have been moved and ids holds their ids in the file */
+struct Index {
+    const Engine* engine;
+    const Categories* categories;
+    const Planner* planner;
+    const QuantizedDatabase* quantized;
+    const Graph* graph;
+    const uint32_t* ids;
+};
+
+/* The engine over-fetches QUANTIZED_CANDIDATES by their quantized distances,
+ * then the exact distances over db pick the nearest of them */
+template <typename DB>
+inline void SearchQuantized(const DB& db, const QuantizedDatabase& quantized, const Engine* engine,
+                            const Query& query, Scoreboard& scoreboard) {
+    thread_local FixedScoreboard<QUANTIZED_CANDIDATES> candidates;
+    thread_local Candidate found[QUANTIZED_CANDIDATES];
+    engine->search(quantized, query, candidates);
+    const uint32_t count = candidates.drain(found);
+    for (uint32_t i = 0; i < count; i++) {
+        scoreboard.push(found[i].index, fast_distance(query, view_of(db, found[i].index)));
+    }
+}
+
+/* One query, from start to finish: a scan if the planner says so, the categories
+ * for the C-filtered ones, the engine otherwise */
+template <typename DB>
+inline void Answer(const DB& db, const Query& query, const Index& index, Scoreboard& scoreboard) {
+    PROFILE_QUERY(query);
+    const Planner* planner = index.planner;
+    const Plan plan = planner != nullptr ? planner->plan(query) : Plan { ROUTE_INDEX, 0, 0, false };
+    if (plan.route != ROUTE_INDEX) {
+        planner->scan(db, query, plan, scoreboard);
+        return;
+    }
+    if (index.categories != nullptr && Categories::handles(query)) {
+        index.categories->search(db, query, scoreboard);
+    } else if (index.graph != nullptr) {
+        index.graph->search(db, query, scoreboard);
+    } else if (index.quantized != nullptr) {
+        SearchQuantized(db, *index.quantized, index.engine, query, scoreboard);
+    } else {
+        index.engine->search(db, query, scoreboard);
+    }
+    if (planner != nullptr)
+        planner->record(query, plan);
+}
+
+/* Queries are answered in the order given by order, results stay in file order */
+template <typename DB>
+void Workload(const DB& db, const QuerySet& qs, const uint32_t* order, const Index& index, Solution& solution) {
+    #ifdef ENABLE_OMP
+    #pragma omp parallel
+    #endif
+    {
+        Scoreboard scoreboard;
+        #ifdef ENABLE_OMP
+        #pragma omp for schedule(dynamic, QUERY_CHUNK_SIZE)
+        #endif
+        for (uint32_t j = 0; j < qs.length; j++) {
+            const uint32_t i = order[j];
+            Answer(db, qs.queries[i], index, scoreboard);
+            Flush(scoreboard, solution.results + (uint64_t) i * k_nearest_neighbors, index.ids);
+        }
+    }
+}
+
+/* Every query the planner doesn't scan is answered exactly, EXACT_QUERY_TILE at a time,
+ * so the database is read once per tile instead of once per query */
+template <typename DB>
+void ExactWorkload(const DB& db, const QuerySet& qs, const uint32_t* order, const Exact* exact,
+                   const Planner* planner, Solution& solution, const uint32_t* ids = nullptr) {
+    const uint32_t tiles = (qs.length + EXACT_QUERY_TILE - 1) / EXACT_QUERY_TILE;
+    #ifdef ENABLE_OMP
+    #pragma omp parallel
+    #endif
+    {
+        Scoreboard* scoreboards = new Scoreboard[EXACT_QUERY_TILE];
+        const Query* batch[EXACT_QUERY_TILE];
+        uint32_t batch_ids[EXACT_QUERY_TILE];
+        #ifdef ENABLE_OMP
+        #pragma omp for schedule(dynamic, 1)
+        #endif
+        for (uint32_t t = 0; t < tiles; t++) {
+            const uint32_t first = t * EXACT_QUERY_TILE;
+            const uint32_t last = std::min<uint32_t>(first + EXACT_QUERY_TILE, qs.length);
+            uint32_t batch_length = 0;
+            for (uint32_t j = first; j < last; j++) {
+                const uint32_t i = order[j];
+                const Query& query = qs.queries[i];
+                const Plan plan = planner != nullptr ? planner->plan(query) : Plan { ROUTE_INDEX, 0, 0, false };
+                if (plan.route != ROUTE_INDEX) {
+                    planner->scan(db, query, plan, scoreboards[0]);
+                    Flush(scoreboards[0], solution.results + (uint64_t) i * k_nearest_neighbors, ids);
+                } else {
+                    if (planner != nullptr)
+                        planner->record(query, plan);
+                    batch[batch_length] = &query;
+                    batch_ids[batch_length++] = i;
+                }
+            }
+            exact->search(db, batch, batch_length, scoreboards);
+            for (uint32_t b = 0; b < batch_length; b++) {
+                Flush(scoreboards[b], solution.results + (uint64_t) batch_ids[b] * k_nearest_neighbors, ids);
+            }
+        }
+        delete[] scoreboards;
+    }
+}
+
+#endif
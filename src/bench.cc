@@ -0,0 +1,343 @@
+#include <sigmod/config.hh>
+#include <sigmod/query_set.hh>
+#include <sigmod/database.hh>
+#include <sigmod/columnar.hh>
+#include <sigmod/solution.hh>
+#include <sigmod/memory.hh>
+#include <sigmod/mapping.hh>
+#include <sigmod/schedule.hh>
+#include <sigmod/workload.hh>
+#include <sigmod/flags.hh>
+#include <omp.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+/* Measures recall and speed of the index on a query set, against exact ground truth:
+ *
+ *   bench.exe data.bin queries.bin [truth.bin] [report.json] [tree|graph]
+ *
+ * The ground truth is computed with the exact engine and saved to truth.bin
+ * (queries.bin.truth by default) the first time, and read back afterwards
+ * unless it was computed over another database, see TruthHeader.
+ * The report is JSON, written to report.json (bench.json by default). With ENABLE_PROFILE
+ * it holds the counters of the latency pass too, see profile.hh. */
+
+const char* query_type_names[query_type_count] = { "normal", "by_c", "by_t", "by_c_and_t" };
+
+typedef std::chrono::steady_clock Clock;
+
+double ElapsedSeconds(const Clock::time_point start, const Clock::time_point end) {
+  return std::chrono::duration<double>(end - start).count();
+}
+
+/* The share of the distinct neighbours in truth matched by result, padding aside;
+ * 1 when truth has none. Ties count: a neighbour of result that matches the query
+ * and is no further than the furthest of truth is as good as the one it replaces.
+ * Ids are those of the files, positions[id] is where id is in db (nullptr if it hasn't moved). */
+template <typename DB>
+double Recall(const DB& db, const Query& query, const uint32_t* result, const uint32_t* truth,
+              const uint32_t* positions) {
+  auto position = [positions](const uint32_t id) { return positions != nullptr ? positions[id] : id; };
+  std::vector<uint32_t> expected(truth, truth + k_nearest_neighbors);
+  std::vector<uint32_t> found(result, result + k_nearest_neighbors);
+  expected.erase(std::remove(expected.begin(), expected.end(), missing_neighbor), expected.end());
+  found.erase(std::remove(found.begin(), found.end(), missing_neighbor), found.end());
+  if (expected.empty())
+    return 1;
+  std::sort(expected.begin(), expected.end());
+  expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+  std::sort(found.begin(), found.end());
+  found.erase(std::unique(found.begin(), found.end()), found.end());
+  score_t furthest = 0;
+  for (const uint32_t id : expected) {
+    furthest = std::max(furthest, fast_distance(query, view_of(db, position(id))));
+  }
+  uint32_t hits = 0;
+  for (const uint32_t id : found) {
+    if (id >= db.length)
+      continue;
+    const auto& record = view_of(db, position(id));
+    if (std::binary_search(expected.begin(), expected.end(), id)
+        || (check_if_elegible(query, record) && fast_distance(query, record) <= furthest))
+      hits++;
+  }
+  return (double) std::min<uint64_t>(hits, expected.size()) / expected.size();
+}
+
+/* Ground truth files are a TruthHeader followed by the rows of a solution file,
+ * k_nearest_neighbors uint32_t per query */
+struct TruthHeader {
+  char magic[8];
+  /* see ChecksumDatabase */
+  uint64_t checksum;
+  uint32_t db_length;
+  uint32_t qs_length;
+};
+
+const char truth_magic[8] = {'S', 'I', 'G', 'T', 'R', 'U', 'T', 'H'};
+
+void WriteTruth(const Solution& truth, const TruthHeader& header, const std::string& path) {
+  FILE* output = fopen(path.c_str(), "wb");
+  if (output == nullptr)
+    Panic("unable to open " + path + " for writing");
+  const uint64_t entries = (uint64_t) truth.length * k_nearest_neighbors;
+  if (fwrite(&header, sizeof(TruthHeader), 1, output) != 1
+      || fwrite(truth.results, sizeof(uint32_t), entries, output) != entries)
+    Panic("unable to write " + path);
+  if (fclose(output) != 0)
+    Panic("unable to write " + path);
+}
+
+/* false, leaving truth alone, if path holds the truth of another database or query set */
+bool ReadTruth(Solution& truth, const TruthHeader& expected, const std::string& path) {
+  const uint64_t entries = (uint64_t) expected.qs_length * k_nearest_neighbors;
+  if (FileSize(path) != sizeof(TruthHeader) + entries * sizeof(uint32_t))
+    return false;
+  FILE* input = fopen(path.c_str(), "rb");
+  if (input == nullptr)
+    Panic("unable to open " + path + " for reading");
+  TruthHeader header;
+  if (fread(&header, sizeof(TruthHeader), 1, input) != 1)
+    Panic("unable to read " + path);
+  if (std::memcmp(header.magic, expected.magic, sizeof(truth_magic)) != 0 || header.checksum != expected.checksum
+      || header.db_length != expected.db_length || header.qs_length != expected.qs_length) {
+    fclose(input);
+    return false;
+  }
+  truth = NewSolution(expected.qs_length);
+  if (fread(truth.results, sizeof(uint32_t), entries, input) != entries)
+    Panic("unable to read " + path);
+  fclose(input);
+  return true;
+}
+
+/* latencies are sorted */
+double Percentile(const std::vector<double>& latencies, double fraction) {
+  if (latencies.empty())
+    return 0;
+  const uint64_t rank = std::min<uint64_t>(latencies.size() - 1, fraction * latencies.size());
+  return latencies[rank];
+}
+
+struct TypeReport {
+  uint32_t queries;
+  double recall;
+  std::vector<double> latencies;
+  uint64_t distances;
+};
+
+void WriteLatencies(std::ofstream& output, std::vector<double>& latencies) {
+  std::sort(latencies.begin(), latencies.end());
+  output << "{ \"p50\": " << Percentile(latencies, 0.50)
+         << ", \"p95\": " << Percentile(latencies, 0.95)
+         << ", \"p99\": " << Percentile(latencies, 0.99) << " }";
+}
+
+int main(int argc, char** args) {
+  omp_set_num_threads(omp_get_max_threads());
+
+  std::string db_path = "dummy-data.bin";
+  std::string qs_path = "dummy-queries.bin";
+
+  if (argc > 1)
+    db_path = std::string(args[1]);
+  if (argc > 2)
+    qs_path = std::string(args[2]);
+  std::string truth_path = argc > 3 ? std::string(args[3]) : qs_path + ".truth";
+  std::string report_path = argc > 4 ? std::string(args[4]) : "bench.json";
+  const std::string engine_name = argc > 5 ? std::string(args[5]) : "tree";
+  const bool use_graph = UseGraph(engine_name);
+
+  #ifdef ENABLE_MMAP
+  Database db = MapDatabase(db_path);
+  QuerySet qs = MapQuerySet(qs_path);
+  #else
+  Database db = ReadDatabase(db_path);
+  QuerySet qs = ReadQuerySet(qs_path);
+  #endif
+  LogTime("Read DB and QS");
+
+  /* identifies the database of the saved trees and of the ground truth */
+  const uint64_t checksum = ChecksumDatabase(db);
+  #ifdef ENABLE_PERSISTENT_INDEX
+  const std::string tree_path = db_path + ".tree";
+  #else
+  const std::string tree_path = "";
+  #endif
+
+  #ifdef ENABLE_COLUMNAR_DATABASE
+  ColumnarDatabase cdb = BuildColumnarDatabase(db);
+  FreeDatabase(db);
+  #else
+  Database& cdb = db;
+  #endif
+
+  uint32_t* identity = smalloc<uint32_t>(std::max<uint32_t>(qs.length, 1), "identity");
+  for (uint32_t i = 0; i < qs.length; i++) {
+    identity[i] = i;
+  }
+
+  TruthHeader truth_header = {};
+  std::memcpy(truth_header.magic, truth_magic, sizeof(truth_magic));
+  truth_header.checksum = checksum;
+  truth_header.db_length = cdb.length;
+  truth_header.qs_length = qs.length;
+  Solution truth;
+  const bool existed = FileExists(truth_path);
+  if (existed && ReadTruth(truth, truth_header, truth_path)) {
+    LogTime("Read Ground Truth " + truth_path);
+  } else {
+    if (existed)
+      Debug(truth_path + " is not the ground truth of this database and query set, recomputing it");
+    Exact* exact = Exact::New(cdb);
+    truth = NewSolution(qs.length);
+    ExactWorkload(cdb, qs, identity, exact, nullptr, truth);
+    Exact::Free(exact);
+    WriteTruth(truth, truth_header, truth_path);
+    LogTime("Computed Ground Truth " + truth_path);
+  }
+
+  const Clock::time_point build_start = Clock::now();
+  Engine* engine = LoadEngine(cdb, checksum, tree_path);
+  #ifdef ENABLE_LEAF_LAYOUT
+  uint32_t* ids = LayoutByLeaves(cdb, engine);
+  #else
+  uint32_t* ids = nullptr;
+  #endif
+  #ifdef ENABLE_CATEGORIES
+  Categories* categories = Categories::New(cdb);
+  #else
+  Categories* categories = nullptr;
+  #endif
+  #ifdef ENABLE_PLANNER
+  Planner* planner = Planner::New(cdb, categories);
+  #else
+  Planner* planner = nullptr;
+  #endif
+
+  Graph* graph = use_graph ? BuildGraph(cdb, engine) : nullptr;
+
+  #ifdef ENABLE_QUANTIZATION
+  QuantizedDatabase quantized = BuildQuantizedDatabase(cdb);
+  const Index index = { engine, categories, planner, &quantized, graph, ids };
+  #else
+  const Index index = { engine, categories, planner, nullptr, graph, ids };
+  #endif
+  const double build_seconds = ElapsedSeconds(build_start, Clock::now());
+  LogTime("Built Index");
+
+  /* throughput, with every thread and the same schedule as main */
+  Solution solution = NewSolution(qs.length);
+  const Clock::time_point workload_start = Clock::now();
+  #ifdef ENABLE_QUERY_SCHEDULE
+  uint32_t* order = ScheduleQueries(qs, FirstTree(engine));
+  #else
+  uint32_t* order = identity;
+  #endif
+  Workload(cdb, qs, order, index, solution);
+  const double workload_seconds = ElapsedSeconds(workload_start, Clock::now());
+  LogTime("Answered QS");
+
+  /* where the records of the files are in cdb, for the recall */
+  uint32_t* positions = nullptr;
+  if (ids != nullptr) {
+    positions = smalloc<uint32_t>(std::max<uint32_t>(cdb.length, 1), "positions");
+    for (uint32_t i = 0; i < cdb.length; i++) {
+      positions[ids[i]] = i;
+    }
+  }
+
+  /* latency and distances, one query at a time on this thread */
+  TypeReport reports[query_type_count] = {};
+  ResetProfile();
+  Scoreboard scoreboard;
+  uint32_t* scratch = smalloc<uint32_t>(k_nearest_neighbors, "scratch");
+  for (uint32_t i = 0; i < qs.length; i++) {
+    const Query& query = qs.queries[i];
+    TypeReport& report = reports[std::min<uint32_t>(query.query_type, query_type_count - 1)];
+    const Clock::time_point start = Clock::now();
+    Answer(cdb, query, index, scoreboard);
+    Flush(scoreboard, scratch);
+    report.latencies.push_back(ElapsedSeconds(start, Clock::now()) * 1e6);
+    report.recall += Recall(cdb, query, solution.results + (uint64_t) i * k_nearest_neighbors,
+                            truth.results + (uint64_t) i * k_nearest_neighbors, positions);
+    report.queries++;
+  }
+  LogTime("Measured Latencies");
+  const ProfileTotals profile = TotalProfile();
+
+  std::vector<double> latencies;
+  double recall = 0;
+  uint64_t distances = 0;
+  for (uint32_t t = 0; t < query_type_count; t++) {
+    reports[t].distances = profile.counts[t][COUNTER_DISTANCES];
+    latencies.insert(latencies.end(), reports[t].latencies.begin(), reports[t].latencies.end());
+    recall += reports[t].recall;
+    distances += reports[t].distances;
+  }
+
+  std::ofstream output(report_path);
+  if (!output)
+    Panic("unable to open " + report_path + " for writing");
+  output << "{\n";
+  output << "  \"records\": " << cdb.length << ",\n";
+  output << "  \"queries\": " << qs.length << ",\n";
+  output << "  \"k\": " << k_nearest_neighbors << ",\n";
+  output << "  \"threads\": " << omp_get_max_threads() << ",\n";
+  output << "  \"kernels\": \"" << SIGMOD_DISTANCE_KERNELS.name << "\",\n";
+  output << "  \"engine\": \"" << engine_name << "\",\n";
+  output << "  \"build_seconds\": " << build_seconds << ",\n";
+  output << "  \"workload_seconds\": " << workload_seconds << ",\n";
+  output << "  \"throughput_qps\": " << (workload_seconds > 0 ? qs.length / workload_seconds : 0) << ",\n";
+  output << "  \"recall\": " << (qs.length > 0 ? recall / qs.length : 0) << ",\n";
+  output << "  \"distances_per_query\": " << (qs.length > 0 ? (double) distances / qs.length : 0) << ",\n";
+  output << "  \"latency_us\": ";
+  WriteLatencies(output, latencies);
+  output << ",\n  \"types\": {\n";
+  for (uint32_t t = 0; t < query_type_count; t++) {
+    TypeReport& report = reports[t];
+    const double queries = std::max<uint32_t>(report.queries, 1);
+    output << "    \"" << query_type_names[t] << "\": { \"queries\": " << report.queries
+           << ", \"recall\": " << report.recall / queries
+           << ", \"distances_per_query\": " << report.distances / queries
+           << ", \"latency_us\": ";
+    WriteLatencies(output, report.latencies);
+    output << " }" << (t + 1 < query_type_count ? "," : "") << "\n";
+  }
+  output << "  }";
+  #ifdef ENABLE_PROFILE
+  output << ",\n  \"profile\": ";
+  WriteProfile(output);
+  #endif
+  output << "\n}\n";
+  output.close();
+  LogTime("Wrote Report " + report_path);
+
+  #ifdef ENABLE_QUERY_SCHEDULE
+  sfree(order);
+  #endif
+  sfree(scratch);
+  if (positions != nullptr)
+    sfree(positions);
+  if (ids != nullptr)
+    sfree(ids);
+  sfree(identity);
+  FreeSolution(solution);
+  FreeSolution(truth);
+  FreeEngine(engine);
+  Graph::Free(graph);
+  #ifdef ENABLE_QUANTIZATION
+  FreeQuantizedDatabase(quantized);
+  #endif
+  Planner::Free(planner);
+  Categories::Free(categories);
+  #ifdef ENABLE_COLUMNAR_DATABASE
+  FreeColumnarDatabase(cdb);
+  #else
+  FreeDatabase(db);
+  #endif
+  FreeQuerySet(qs);
+}
@@ -0,0 +1,206 @@
+#include <sigmod/config.hh>
+#include <sigmod/database.hh>
+#include <sigmod/query_set.hh>
+#include <sigmod/random.hh>
+#include <sigmod/debug.hh>
+#include <sigmod/memory.hh>
+#include <sigmod/flags.hh>
+#include <omp.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+/* Writes a synthetic Database and QuerySet in the contest format:
+ *
+ *   generate.exe data.bin queries.bin [key=value ...]
+ *
+ *   records=1000000   length of the database
+ *   queries=10000     length of the query set
+ *   categories=1000   distinct values of C, which are 0, 1, ...
+ *   skew=1.0          C follows a zipf law with this exponent, 0 is uniform
+ *   t=uniform         T is uniform in [0, 1], or "normal" around 0.5
+ *   window=0.1        width of the [l, r] windows of T-filtered queries
+ *   mix=1,1,1,1       weights of NORMAL, BY_C, BY_T and BY_C_AND_T queries
+ *   clusters=128      vectors are normal noise around this many centers
+ *   spread=0.1        standard deviation of the noise around the centers
+ *   seed=0
+ *
+ * Records are generated in chunks of GENERATE_CHUNK_LENGTH, each from its own
+ * stream of seed, so the output only depends on the parameters and not on the threads. */
+
+const uint32_t GENERATE_CHUNK_LENGTH = 65536;
+
+struct GenerateParameters {
+  uint32_t records = 1000000;
+  uint32_t queries = 10000;
+  uint32_t categories = 1000;
+  float32_t skew = 1.0;
+  bool normal_T = false;
+  float32_t window = 0.1;
+  float32_t mix[4] = { 1, 1, 1, 1 };
+  uint32_t clusters = 128;
+  float32_t spread = 0.1;
+  uint64_t seed = 0;
+};
+
+GenerateParameters ParseParameters(int argc, char** args) {
+  GenerateParameters parameters;
+  for (int i = 3; i < argc; i++) {
+    const std::string argument = args[i];
+    const size_t equals = argument.find('=');
+    if (equals == std::string::npos)
+      Panic("expected key=value, got " + argument);
+    const std::string key = argument.substr(0, equals);
+    const std::string value = argument.substr(equals + 1);
+    if (key == "records") {
+      parameters.records = std::stoul(value);
+    } else if (key == "queries") {
+      parameters.queries = std::stoul(value);
+    } else if (key == "categories") {
+      parameters.categories = std::max<uint32_t>(std::stoul(value), 1);
+    } else if (key == "skew") {
+      parameters.skew = std::stof(value);
+    } else if (key == "t") {
+      if (value != "uniform" && value != "normal")
+        Panic("t is either uniform or normal, got " + value);
+      parameters.normal_T = value == "normal";
+    } else if (key == "window") {
+      parameters.window = std::stof(value);
+    } else if (key == "mix") {
+      if (std::sscanf(value.c_str(), "%f,%f,%f,%f", &parameters.mix[0], &parameters.mix[1],
+                      &parameters.mix[2], &parameters.mix[3]) != 4)
+        Panic("mix takes four comma separated weights, got " + value);
+    } else if (key == "clusters") {
+      parameters.clusters = std::max<uint32_t>(std::stoul(value), 1);
+    } else if (key == "spread") {
+      parameters.spread = std::stof(value);
+    } else if (key == "seed") {
+      parameters.seed = std::stoull(value);
+    } else {
+      Panic("unknown parameter " + key);
+    }
+  }
+  return parameters;
+}
+
+/* draws an index with probability proportional to its weight, cumulative is the running sum */
+uint32_t Draw(Xoshiro256& generator, const std::vector<double>& cumulative) {
+  const double u = generator.uniform(0.0f, 1.0f) * cumulative.back();
+  const auto found = std::upper_bound(cumulative.begin(), cumulative.end(), u);
+  return std::min<uint32_t>(found - cumulative.begin(), cumulative.size() - 1);
+}
+
+/* roughly standard normal and much cheaper than Box-Muller: the sum of four 16 bit uniforms */
+inline float32_t Noise(Xoshiro256& generator) {
+  const uint64_t bits = generator.next();
+  const uint32_t sum = (bits & 0xffff) + ((bits >> 16) & 0xffff) + ((bits >> 32) & 0xffff) + (bits >> 48);
+  return (sum * (1.0f / 65536) - 2.0f) * 1.7320508f;
+}
+
+float32_t DrawT(Xoshiro256& generator, const GenerateParameters& parameters) {
+  if (!parameters.normal_T)
+    return generator.uniform(0.0f, 1.0f);
+  return std::clamp(0.5f + 0.15f * generator.normal(), 0.0f, 1.0f);
+}
+
+void DrawVector(Xoshiro256& generator, const GenerateParameters& parameters,
+                const float32_t* centers, float32_t* fields) {
+  const float32_t* center = centers + (uint64_t) generator.uniform(0u, parameters.clusters) * vector_num_dimension;
+  for (uint32_t d = 0; d < vector_num_dimension; d++) {
+    fields[d] = center[d] + parameters.spread * Noise(generator);
+  }
+}
+
+/* streams[i] is Xoshiro256::Stream(seed, first + i), computed with one jump each */
+std::vector<Xoshiro256> Streams(uint64_t seed, uint64_t first, uint32_t length) {
+  std::vector<Xoshiro256> streams;
+  Xoshiro256 generator = Xoshiro256::Stream(seed, first);
+  for (uint32_t i = 0; i < length; i++) {
+    streams.push_back(generator);
+    generator.jump();
+  }
+  return streams;
+}
+
+int main(int argc, char** args) {
+  omp_set_num_threads(omp_get_max_threads());
+
+  if (argc < 3)
+    Panic("usage: generate.exe data.bin queries.bin [key=value ...]");
+  const std::string db_path = args[1];
+  const std::string qs_path = args[2];
+  const GenerateParameters parameters = ParseParameters(argc, args);
+
+  std::vector<double> categories(parameters.categories);
+  for (uint32_t k = 0; k < parameters.categories; k++) {
+    categories[k] = (k > 0 ? categories[k - 1] : 0) + 1.0 / std::pow(k + 1.0, parameters.skew);
+  }
+  std::vector<double> mix(4);
+  for (uint32_t t = 0; t < 4; t++) {
+    mix[t] = (t > 0 ? mix[t - 1] : 0) + parameters.mix[t];
+  }
+
+  /* stream 0 is for the centers, then one per chunk of records and one per chunk of queries */
+  Xoshiro256 center_generator = Xoshiro256::Stream(parameters.seed, 0);
+  std::vector<float32_t> centers((uint64_t) parameters.clusters * vector_num_dimension);
+  for (float32_t& coordinate : centers) {
+    coordinate = center_generator.normal();
+  }
+  const uint32_t record_chunks = (parameters.records + GENERATE_CHUNK_LENGTH - 1) / GENERATE_CHUNK_LENGTH;
+  const uint32_t query_chunks = (parameters.queries + GENERATE_CHUNK_LENGTH - 1) / GENERATE_CHUNK_LENGTH;
+  std::vector<Xoshiro256> streams = Streams(parameters.seed, 1, record_chunks + query_chunks);
+
+  Record* records = (Record*) Allocate(sizeof(Record) * parameters.records, MEMORY_DATABASE, "the generated records");
+  Query* queries = (Query*) Allocate(sizeof(Query) * parameters.queries, MEMORY_QUERY_SET, "the generated queries");
+
+  #ifdef ENABLE_OMP
+  #pragma omp parallel for schedule(dynamic, 1)
+  #endif
+  for (uint32_t chunk = 0; chunk < record_chunks; chunk++) {
+    Xoshiro256 generator = streams[chunk];
+    const uint32_t end = std::min<uint32_t>((chunk + 1) * GENERATE_CHUNK_LENGTH, parameters.records);
+    for (uint32_t i = chunk * GENERATE_CHUNK_LENGTH; i < end; i++) {
+      records[i].C = Draw(generator, categories);
+      records[i].T = DrawT(generator, parameters);
+      DrawVector(generator, parameters, centers.data(), records[i].fields);
+    }
+  }
+  LogTime("Generated " + std::to_string(parameters.records) + " records");
+
+  #ifdef ENABLE_OMP
+  #pragma omp parallel for schedule(dynamic, 1)
+  #endif
+  for (uint32_t chunk = 0; chunk < query_chunks; chunk++) {
+    Xoshiro256 generator = streams[record_chunks + chunk];
+    const uint32_t end = std::min<uint32_t>((chunk + 1) * GENERATE_CHUNK_LENGTH, parameters.queries);
+    for (uint32_t i = chunk * GENERATE_CHUNK_LENGTH; i < end; i++) {
+      Query& query = queries[i];
+      const uint32_t query_type = Draw(generator, mix);
+      query.query_type = query_type;
+      query.v = -1;
+      query.l = -1;
+      query.r = -1;
+      if (query_type == BY_C || query_type == BY_C_AND_T) {
+        query.v = Draw(generator, categories);
+      }
+      if (query_type == BY_T || query_type == BY_C_AND_T) {
+        query.l = generator.uniform(0.0f, std::max(0.0f, 1.0f - parameters.window));
+        query.r = query.l + parameters.window;
+      }
+      DrawVector(generator, parameters, centers.data(), query.fields);
+    }
+  }
+  LogTime("Generated " + std::to_string(parameters.queries) + " queries");
+
+  Database db = { .length = parameters.records, .records = records, .mapping = { nullptr, 0 } };
+  WriteDatabase(db, db_path);
+  LogTime("Wrote " + db_path);
+
+  QuerySet qs = { .length = parameters.queries, .queries = queries, .mapping = { nullptr, 0 } };
+  WriteQuerySet(qs, qs_path);
+  LogTime("Wrote " + qs_path);
+
+  FreeDatabase(db);
+  FreeQuerySet(qs);
+}
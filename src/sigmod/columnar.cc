@@ -0,0 +1,128 @@
+#include <sigmod/columnar.hh>
+#include <sigmod/debug.hh>
+#include <sigmod/memory.hh>
+#include <sigmod/flags.hh>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+ColumnarDatabase BuildColumnarDatabase(const Database& database) {
+    const uint32_t length = database.length;
+    const uint64_t vectors_size = (uint64_t) length * vector_stride * sizeof(float32_t);
+
+    float32_t* C = (float32_t*) Allocate(sizeof(float32_t) * length, MEMORY_DATABASE, "columnar C");
+    float32_t* T = (float32_t*) Allocate(sizeof(float32_t) * length, MEMORY_DATABASE, "columnar T");
+    float32_t* vectors = (float32_t*) AllocateAligned(vectors_size, vector_alignment, MEMORY_DATABASE, "columnar vectors");
+
+    #ifdef ENABLE_OMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (uint32_t i = 0; i < length; i++) {
+        const Record& record = database.records[i];
+        float32_t* row = vectors + (uint64_t) i * vector_stride;
+        C[i] = record.C;
+        T[i] = record.T;
+        std::memcpy(row, record.fields, sizeof(float32_t) * vector_num_dimension);
+        std::memset(row + vector_num_dimension, 0, sizeof(float32_t) * (vector_stride - vector_num_dimension));
+        #ifdef ENABLE_METRICS_PRUNING
+        const Metrics metrics = metrics_of(record);
+        row[vector_num_dimension] = metrics.diagonal;
+        row[vector_num_dimension + 1] = metrics.spread;
+        #endif
+    }
+
+    #ifdef ENABLE_PCA
+    PCA* pca = PCA::New(vectors, length, vector_stride);
+    float32_t* projections = (float32_t*) AllocateAligned((uint64_t) length * PCA_COMPONENTS * sizeof(float32_t),
+        vector_alignment, MEMORY_DATABASE, "columnar projections");
+    #ifdef ENABLE_OMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (uint32_t i = 0; i < length; i++) {
+        pca->project(vectors + (uint64_t) i * vector_stride, projections + (uint64_t) i * PCA_COMPONENTS);
+    }
+    #else
+    PCA* pca = nullptr;
+    float32_t* projections = nullptr;
+    #endif
+
+    return {
+        .length = length,
+        .C = C,
+        .T = T,
+        .vectors = vectors,
+        .pca = pca,
+        .projections = projections
+    };
+}
+
+/* Row i of the columnar database, moved as a whole */
+struct ColumnarRow {
+    float32_t C;
+    float32_t T;
+    float32_t vector[vector_stride];
+    float32_t projection[PCA_COMPONENTS];
+};
+
+inline void LoadRow(const ColumnarDatabase& database, const uint32_t i, ColumnarRow& row) {
+    row.C = database.C[i];
+    row.T = database.T[i];
+    std::memcpy(row.vector, database.vectors + (uint64_t) i * vector_stride, sizeof(row.vector));
+    if (database.projections != nullptr)
+        std::memcpy(row.projection, database.projections + (uint64_t) i * PCA_COMPONENTS, sizeof(row.projection));
+}
+
+inline void StoreRow(ColumnarDatabase& database, const uint32_t i, const ColumnarRow& row) {
+    database.C[i] = row.C;
+    database.T[i] = row.T;
+    std::memcpy(database.vectors + (uint64_t) i * vector_stride, row.vector, sizeof(row.vector));
+    if (database.projections != nullptr)
+        std::memcpy(database.projections + (uint64_t) i * PCA_COMPONENTS, row.projection, sizeof(row.projection));
+}
+
+inline void MoveRow(ColumnarDatabase& database, const uint32_t from, const uint32_t to) {
+    database.C[to] = database.C[from];
+    database.T[to] = database.T[from];
+    std::memcpy(database.vectors + (uint64_t) to * vector_stride, database.vectors + (uint64_t) from * vector_stride,
+                sizeof(float32_t) * vector_stride);
+    if (database.projections != nullptr)
+        std::memcpy(database.projections + (uint64_t) to * PCA_COMPONENTS, database.projections + (uint64_t) from * PCA_COMPONENTS,
+                    sizeof(float32_t) * PCA_COMPONENTS);
+}
+
+/* In place, one cycle of the permutation at a time, so that the vectors are never
+ * held twice: only a bit per record is allocated to tell the cycles already done. */
+void PermuteColumnarDatabase(ColumnarDatabase& database, const uint32_t* order) {
+    const uint32_t length = database.length;
+    uint64_t* moved = (uint64_t*) AllocateZeroed(sizeof(uint64_t) * ((length + 63) / 64), MEMORY_OTHER, "the permuted records");
+    ColumnarRow first;
+    for (uint32_t start = 0; start < length; start++) {
+        if ((moved[start / 64] >> (start % 64)) & 1 || order[start] == start)
+            continue;
+        LoadRow(database, start, first);
+        uint32_t i = start;
+        while (order[i] != start) {
+            MoveRow(database, order[i], i);
+            moved[i / 64] |= (uint64_t) 1 << (i % 64);
+            i = order[i];
+        }
+        StoreRow(database, i, first);
+        moved[i / 64] |= (uint64_t) 1 << (i % 64);
+    }
+    Deallocate(moved);
+}
+
+void FreeColumnarDatabase(ColumnarDatabase& database) {
+    if (database.vectors == nullptr)
+        return;
+    Deallocate(database.C);
+    Deallocate(database.T);
+    Deallocate(database.vectors);
+    Deallocate(database.projections);
+    PCA::Free(database.pca);
+    database.C = nullptr;
+    database.T = nullptr;
+    database.vectors = nullptr;
+    database.projections = nullptr;
+    database.length = 0;
+}
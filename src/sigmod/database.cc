@@ -1,15 +1,23 @@
 #include <sigmod/database.hh>
+#include <sigmod/debug.hh>
+#include <sigmod/memory.hh>
+#include <sigmod/flags.hh>
 #include <cstdio>
 #include <algorithm>
 #include <iostream>
+#include <cstring>
 
 Database ReadDatabase(std::string input_path) {
     FILE* dbfile = fopen(input_path.c_str(), "rb");
-    
+    if (dbfile == nullptr)
+        Panic("unable to open " + input_path);
+
     uint32_t db_length;
-    fread(&db_length, sizeof(uint32_t), 1, dbfile);
+    if (fread(&db_length, sizeof(uint32_t), 1, dbfile) != 1)
+        Panic("unable to read the header of " + input_path);
+    CheckFileLength(input_path, FileSize(input_path), db_length, sizeof(Record));
 
-    Record* records = (Record*) std::malloc(sizeof(Record) * db_length);
+    Record* records = (Record*) AllocateAligned(sizeof(Record) * db_length, cache_line_length, MEMORY_DATABASE, input_path);
     Record* records_entry_point = records;
     uint32_t records_to_read = db_length;
     while(records_to_read > 0) {
@@ -17,7 +25,8 @@ Database ReadDatabase(std::string input_path) {
         if (this_batch > records_to_read) {
             this_batch = records_to_read;
         }
-        fread(records_entry_point, sizeof(Record), this_batch, dbfile);
+        if (fread(records_entry_point, sizeof(Record), this_batch, dbfile) != this_batch)
+            Panic("unexpected end of " + input_path);
         records_to_read -= this_batch;
         records_entry_point += this_batch;
     }
@@ -25,12 +34,30 @@ Database ReadDatabase(std::string input_path) {
 
     return {
         .length = db_length,
-        .records = records
+        .records = records,
+        .mapping = {nullptr, 0}
+    };
+}
+
+Database MapDatabase(std::string input_path) {
+    Mapping mapping = MapFile(input_path);
+
+    if (mapping.length < sizeof(uint32_t))
+        Panic("unable to read the header of " + input_path);
+    const uint32_t db_length = *((uint32_t*) mapping.address);
+    CheckFileLength(input_path, mapping.length, db_length, sizeof(Record));
+
+    return {
+        .length = db_length,
+        .records = (Record*) ((char*) mapping.address + sizeof(uint32_t)),
+        .mapping = mapping
     };
 }
 
 void WriteDatabase(const Database& database, std::string input_path) {
     FILE* dbfile = fopen(input_path.c_str(), "wb");
+    if (dbfile == nullptr)
+        Panic("unable to open " + input_path + " for writing");
     
     uint32_t db_length = database.length;
     fwrite(&db_length, sizeof(uint32_t), 1, dbfile);
@@ -52,7 +79,51 @@ void WriteDatabase(const Database& database, std::string input_path) {
 void FreeDatabase(Database& database) {
     if (database.records == nullptr)
         return;
-    free(database.records);
+    if (database.mapping.address != nullptr) {
+        UnmapFile(database.mapping);
+    } else {
+        Deallocate(database.records);
+    }
     database.records = nullptr;
     database.length = 0;
 }
+
+inline uint64_t MixChecksum(uint64_t hash, uint64_t word) {
+    hash ^= word + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    return hash * 0xff51afd7ed558ccdull;
+}
+
+uint64_t ChecksumDatabase(const Database& database) {
+    /* chunks are hashed in parallel, then combined in order */
+    const uint32_t chunk_length = batch_size;
+    const uint32_t chunks = (database.length + chunk_length - 1) / chunk_length;
+    uint64_t* hashes = (uint64_t*) Allocate(sizeof(uint64_t) * chunks, MEMORY_OTHER, "the database checksum");
+
+    #ifdef ENABLE_OMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (uint32_t chunk = 0; chunk < chunks; chunk++) {
+        const uint32_t start = chunk * chunk_length;
+        const uint32_t end = std::min(database.length, start + chunk_length);
+        const char* bytes = (const char*) (database.records + start);
+        const uint64_t size = sizeof(Record) * (end - start);
+        uint64_t hash = chunk;
+        uint64_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, bytes + i, sizeof(uint64_t));
+            hash = MixChecksum(hash, word);
+        }
+        for (; i < size; i++) {
+            hash = MixChecksum(hash, (unsigned char) bytes[i]);
+        }
+        hashes[chunk] = hash;
+    }
+
+    uint64_t checksum = MixChecksum(0, database.length);
+    for (uint32_t chunk = 0; chunk < chunks; chunk++) {
+        checksum = MixChecksum(checksum, hashes[chunk]);
+    }
+    Deallocate(hashes);
+    return checksum;
+}
@@ -1,4 +1,6 @@
 #include <sigmod/debug.hh>
+#include <sigmod/memory.hh>
+#include <sigmod/profile.hh>
 #include <chrono>
 #include <cmath>
 
@@ -9,6 +11,12 @@ void LogTime(const std::string s) {
     std::cout << "# TIME | " << s << " | el. "
         << std::chrono::duration_cast<std::chrono::milliseconds>(now - SIGMOD_LOG_TIME).count()
         << " ms" << std::endl;
+    /* the peak is that of the phase, ProfilePhase starts the next one */
+    const MemoryUsage usage = ReadMemoryUsage();
+    std::cout << "# MEMORY | " << s << " | Allocated " << BytesToString(usage.current)
+        << " | Peak " << BytesToString(usage.phase_peak)
+        << " | RSS " << BytesToString(usage.rss) << std::endl;
+    ProfilePhase(s, std::chrono::duration<double, std::milli>(now - SIGMOD_LOG_TIME).count());
     SIGMOD_LOG_TIME = now;
 }
 
@@ -38,7 +46,7 @@ std::string BytesToString(long double bytes) {
     } else if (bytes > KILO) {
         rep = sround(bytes/KILO) + " KB";
     } else {
-        rep = std::to_string(bytes) + " B";
+        rep = std::to_string((long long) bytes) + " B";
     }
     return rep;
 }
@@ -63,10 +71,17 @@ std::string LengthToString(long double length) {
     return rep;
 }
 
-long long SIGMOD_MEMORY_TRACKER = 0;
-long long SIGMOD_DISTANCE_COMPUTATIONS = 0;
-
 void LogMemory(const std::string s) {
-    std::cout << "# MEMORY | " << s << " | Allocated " << BytesToString(SIGMOD_MEMORY_TRACKER) << std::endl;
-    SIGMOD_MEMORY_TRACKER = 0;
+    const MemoryUsage usage = ReadMemoryUsage();
+    std::cout << "# MEMORY | " << s << " | Allocated " << BytesToString(usage.current)
+        << " | Peak " << BytesToString(usage.peak)
+        << " | RSS " << BytesToString(usage.rss)
+        << " | Peak RSS " << BytesToString(usage.peak_rss) << std::endl;
+    for (uint32_t tag = 0; tag < memory_tag_count; tag++) {
+        if (usage.peak_by_tag[tag] == 0)
+            continue;
+        std::cout << "# MEMORY | " << s << " | " << memory_tag_names[tag]
+            << " | Allocated " << BytesToString(usage.by_tag[tag])
+            << " | Peak " << BytesToString(usage.peak_by_tag[tag]) << std::endl;
+    }
 }
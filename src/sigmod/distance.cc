@@ -0,0 +1,464 @@
+#include <sigmod/distance.hh>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIGMOD_X86
+#include <immintrin.h>
+#endif
+
+/* partial sums are checked against the bound every this many dimensions */
+const uint32_t abandon_stride = 32;
+
+float32_t L2Scalar(const float32_t* a, const float32_t* b) {
+    float32_t sum = 0;
+    for (uint32_t i = 0; i < vector_num_dimension; i++) {
+        const float32_t m = a[i] - b[i];
+        sum += m * m;
+    }
+    return sum;
+}
+
+float32_t L2ScalarBounded(const float32_t* a, const float32_t* b, float32_t bound) {
+    float32_t sum = 0;
+    for (uint32_t i = 0; i < vector_num_dimension; i++) {
+        const float32_t m = a[i] - b[i];
+        sum += m * m;
+        if ((i + 1) % abandon_stride == 0 && sum > bound)
+            return sum;
+    }
+    return sum;
+}
+
+float32_t DotScalar(const float32_t* a, const float32_t* b) {
+    float32_t sum = 0;
+    for (uint32_t i = 0; i < vector_num_dimension; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+float32_t L2QuantizedScalar(const float32_t* a, const uint8_t* codes, const float32_t* minimum, const float32_t* step) {
+    float32_t sum = 0;
+    for (uint32_t i = 0; i < vector_num_dimension; i++) {
+        const float32_t m = a[i] - (minimum[i] + step[i] * codes[i]);
+        sum += m * m;
+    }
+    return sum;
+}
+
+float32_t L2QuantizedScalarBounded(const float32_t* a, const uint8_t* codes, const float32_t* minimum,
+                                   const float32_t* step, float32_t bound) {
+    float32_t sum = 0;
+    for (uint32_t i = 0; i < vector_num_dimension; i++) {
+        const float32_t m = a[i] - (minimum[i] + step[i] * codes[i]);
+        sum += m * m;
+        if ((i + 1) % abandon_stride == 0 && sum > bound)
+            return sum;
+    }
+    return sum;
+}
+
+#ifdef SIGMOD_X86
+
+__attribute__((target("sse3"), always_inline))
+inline float32_t HorizontalSum(__m128 v) {
+    v = _mm_hadd_ps(v, v);
+    v = _mm_hadd_ps(v, v);
+    return _mm_cvtss_f32(v);
+}
+
+__attribute__((target("sse3")))
+float32_t DotSSE(const float32_t* a, const float32_t* b) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    uint32_t i = 0;
+    for (; i + 8 <= vector_num_dimension; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    for (; i + 4 <= vector_num_dimension; i += 4) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    float32_t sum = HorizontalSum(_mm_add_ps(acc0, acc1));
+    for (; i < vector_num_dimension; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+__attribute__((target("sse3")))
+float32_t L2SSE(const float32_t* a, const float32_t* b) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    uint32_t i = 0;
+    for (; i + 8 <= vector_num_dimension; i += 8) {
+        const __m128 m0 = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        const __m128 m1 = _mm_sub_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4));
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(m0, m0));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(m1, m1));
+    }
+    for (; i + 4 <= vector_num_dimension; i += 4) {
+        const __m128 m = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(m, m));
+    }
+    float32_t sum = HorizontalSum(_mm_add_ps(acc0, acc1));
+    for (; i < vector_num_dimension; i++) {
+        const float32_t m = a[i] - b[i];
+        sum += m * m;
+    }
+    return sum;
+}
+
+__attribute__((target("sse3")))
+float32_t L2SSEBounded(const float32_t* a, const float32_t* b, float32_t bound) {
+    __m128 acc = _mm_setzero_ps();
+    uint32_t i = 0;
+    while (i + abandon_stride <= vector_num_dimension) {
+        for (const uint32_t stop = i + abandon_stride; i < stop; i += 4) {
+            const __m128 m = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+            acc = _mm_add_ps(acc, _mm_mul_ps(m, m));
+        }
+        const float32_t partial = HorizontalSum(acc);
+        if (partial > bound)
+            return partial;
+    }
+    for (; i + 4 <= vector_num_dimension; i += 4) {
+        const __m128 m = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        acc = _mm_add_ps(acc, _mm_mul_ps(m, m));
+    }
+    float32_t sum = HorizontalSum(acc);
+    for (; i < vector_num_dimension; i++) {
+        const float32_t m = a[i] - b[i];
+        sum += m * m;
+    }
+    return sum;
+}
+
+/* dimensions [i, i + 4) decoded, codes are widened with unpacks since sse3 has no cvtepu8 */
+__attribute__((target("sse3"), always_inline))
+inline __m128 DecodeSSE(const uint8_t* codes, const float32_t* minimum, const float32_t* step, const uint32_t i) {
+    int32_t packed;
+    std::memcpy(&packed, codes + i, sizeof(packed));
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i widened = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+    return _mm_add_ps(_mm_loadu_ps(minimum + i), _mm_mul_ps(_mm_loadu_ps(step + i), _mm_cvtepi32_ps(widened)));
+}
+
+__attribute__((target("sse3")))
+float32_t L2QuantizedSSE(const float32_t* a, const uint8_t* codes, const float32_t* minimum, const float32_t* step) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    uint32_t i = 0;
+    for (; i + 8 <= vector_num_dimension; i += 8) {
+        const __m128 m0 = _mm_sub_ps(_mm_loadu_ps(a + i), DecodeSSE(codes, minimum, step, i));
+        const __m128 m1 = _mm_sub_ps(_mm_loadu_ps(a + i + 4), DecodeSSE(codes, minimum, step, i + 4));
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(m0, m0));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(m1, m1));
+    }
+    for (; i + 4 <= vector_num_dimension; i += 4) {
+        const __m128 m = _mm_sub_ps(_mm_loadu_ps(a + i), DecodeSSE(codes, minimum, step, i));
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(m, m));
+    }
+    float32_t sum = HorizontalSum(_mm_add_ps(acc0, acc1));
+    for (; i < vector_num_dimension; i++) {
+        const float32_t m = a[i] - (minimum[i] + step[i] * codes[i]);
+        sum += m * m;
+    }
+    return sum;
+}
+
+__attribute__((target("sse3")))
+float32_t L2QuantizedSSEBounded(const float32_t* a, const uint8_t* codes, const float32_t* minimum,
+                                const float32_t* step, float32_t bound) {
+    __m128 acc = _mm_setzero_ps();
+    uint32_t i = 0;
+    while (i + abandon_stride <= vector_num_dimension) {
+        for (const uint32_t stop = i + abandon_stride; i < stop; i += 4) {
+            const __m128 m = _mm_sub_ps(_mm_loadu_ps(a + i), DecodeSSE(codes, minimum, step, i));
+            acc = _mm_add_ps(acc, _mm_mul_ps(m, m));
+        }
+        const float32_t partial = HorizontalSum(acc);
+        if (partial > bound)
+            return partial;
+    }
+    for (; i + 4 <= vector_num_dimension; i += 4) {
+        const __m128 m = _mm_sub_ps(_mm_loadu_ps(a + i), DecodeSSE(codes, minimum, step, i));
+        acc = _mm_add_ps(acc, _mm_mul_ps(m, m));
+    }
+    float32_t sum = HorizontalSum(acc);
+    for (; i < vector_num_dimension; i++) {
+        const float32_t m = a[i] - (minimum[i] + step[i] * codes[i]);
+        sum += m * m;
+    }
+    return sum;
+}
+
+__attribute__((target("avx2,fma"), always_inline))
+inline float32_t HorizontalSum(__m256 v) {
+    const __m128 lanes = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    const __m128 pairs = _mm_add_ps(lanes, _mm_movehl_ps(lanes, lanes));
+    return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+}
+
+__attribute__((target("avx2,fma")))
+float32_t L2AVX2(const float32_t* a, const float32_t* b) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    uint32_t i = 0;
+    for (; i + 16 <= vector_num_dimension; i += 16) {
+        const __m256 m0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+        const __m256 m1 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+        acc0 = _mm256_fmadd_ps(m0, m0, acc0);
+        acc1 = _mm256_fmadd_ps(m1, m1, acc1);
+    }
+    for (; i + 8 <= vector_num_dimension; i += 8) {
+        const __m256 m = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+        acc0 = _mm256_fmadd_ps(m, m, acc0);
+    }
+    float32_t sum = HorizontalSum(_mm256_add_ps(acc0, acc1));
+    for (; i < vector_num_dimension; i++) {
+        const float32_t m = a[i] - b[i];
+        sum += m * m;
+    }
+    return sum;
+}
+
+__attribute__((target("avx2,fma")))
+float32_t L2AVX2Bounded(const float32_t* a, const float32_t* b, float32_t bound) {
+    __m256 acc = _mm256_setzero_ps();
+    uint32_t i = 0;
+    while (i + abandon_stride <= vector_num_dimension) {
+        for (const uint32_t stop = i + abandon_stride; i < stop; i += 8) {
+            const __m256 m = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+            acc = _mm256_fmadd_ps(m, m, acc);
+        }
+        const float32_t partial = HorizontalSum(acc);
+        if (partial > bound)
+            return partial;
+    }
+    for (; i + 8 <= vector_num_dimension; i += 8) {
+        const __m256 m = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+        acc = _mm256_fmadd_ps(m, m, acc);
+    }
+    float32_t sum = HorizontalSum(acc);
+    for (; i < vector_num_dimension; i++) {
+        const float32_t m = a[i] - b[i];
+        sum += m * m;
+    }
+    return sum;
+}
+
+/* Reduced within avx512f: delegating to the avx2 overload, which can't be inlined
+ * here since it also needs fma, cost a call with live zmm state per distance and
+ * made these kernels about 8x slower than the avx2 ones. */
+__attribute__((target("avx512f"), always_inline))
+inline float32_t HorizontalSum(__m512 v) {
+    /* masked extracts, since the plain ones (and _mm512_reduce_add_ps) trip -Wuninitialized on gcc 12 */
+    const __m256 low = _mm256_castpd_ps(
+        _mm512_mask_extractf64x4_pd(_mm256_setzero_pd(), 0xff, _mm512_castps_pd(v), 0));
+    const __m256 high = _mm256_castpd_ps(
+        _mm512_mask_extractf64x4_pd(_mm256_setzero_pd(), 0xff, _mm512_castps_pd(v), 1));
+    const __m256 octet = _mm256_add_ps(low, high);
+    const __m128 quad = _mm_add_ps(_mm256_castps256_ps128(octet), _mm256_extractf128_ps(octet, 1));
+    const __m128 pair = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+    return _mm_cvtss_f32(_mm_add_ss(pair, _mm_shuffle_ps(pair, pair, 1)));
+}
+
+__attribute__((target("avx2,fma")))
+float32_t DotAVX2(const float32_t* a, const float32_t* b) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    uint32_t i = 0;
+    for (; i + 16 <= vector_num_dimension; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+    }
+    for (; i + 8 <= vector_num_dimension; i += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    }
+    float32_t sum = HorizontalSum(_mm256_add_ps(acc0, acc1));
+    for (; i < vector_num_dimension; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+/* dimensions [i, i + 8) decoded */
+__attribute__((target("avx2,fma"), always_inline))
+inline __m256 DecodeAVX2(const uint8_t* codes, const float32_t* minimum, const float32_t* step, const uint32_t i) {
+    const __m256 code = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) (codes + i))));
+    return _mm256_fmadd_ps(_mm256_loadu_ps(step + i), code, _mm256_loadu_ps(minimum + i));
+}
+
+__attribute__((target("avx2,fma")))
+float32_t L2QuantizedAVX2(const float32_t* a, const uint8_t* codes, const float32_t* minimum, const float32_t* step) {
+    __m256 acc = _mm256_setzero_ps();
+    uint32_t i = 0;
+    for (; i + 8 <= vector_num_dimension; i += 8) {
+        const __m256 m = _mm256_sub_ps(_mm256_loadu_ps(a + i), DecodeAVX2(codes, minimum, step, i));
+        acc = _mm256_fmadd_ps(m, m, acc);
+    }
+    float32_t sum = HorizontalSum(acc);
+    for (; i < vector_num_dimension; i++) {
+        const float32_t m = a[i] - (minimum[i] + step[i] * codes[i]);
+        sum += m * m;
+    }
+    return sum;
+}
+
+__attribute__((target("avx2,fma")))
+float32_t L2QuantizedAVX2Bounded(const float32_t* a, const uint8_t* codes, const float32_t* minimum,
+                                 const float32_t* step, float32_t bound) {
+    __m256 acc = _mm256_setzero_ps();
+    uint32_t i = 0;
+    while (i + abandon_stride <= vector_num_dimension) {
+        for (const uint32_t stop = i + abandon_stride; i < stop; i += 8) {
+            const __m256 m = _mm256_sub_ps(_mm256_loadu_ps(a + i), DecodeAVX2(codes, minimum, step, i));
+            acc = _mm256_fmadd_ps(m, m, acc);
+        }
+        const float32_t partial = HorizontalSum(acc);
+        if (partial > bound)
+            return partial;
+    }
+    for (; i + 8 <= vector_num_dimension; i += 8) {
+        const __m256 m = _mm256_sub_ps(_mm256_loadu_ps(a + i), DecodeAVX2(codes, minimum, step, i));
+        acc = _mm256_fmadd_ps(m, m, acc);
+    }
+    float32_t sum = HorizontalSum(acc);
+    for (; i < vector_num_dimension; i++) {
+        const float32_t m = a[i] - (minimum[i] + step[i] * codes[i]);
+        sum += m * m;
+    }
+    return sum;
+}
+
+/* the tail of the vector is handled with a masked load, so there is no scalar loop */
+const __mmask16 avx512_tail_mask = (__mmask16) ((1u << (vector_num_dimension % 16)) - 1);
+
+__attribute__((target("avx512f")))
+float32_t L2AVX512(const float32_t* a, const float32_t* b) {
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    uint32_t i = 0;
+    for (; i + 32 <= vector_num_dimension; i += 32) {
+        const __m512 m0 = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+        const __m512 m1 = _mm512_sub_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16));
+        acc0 = _mm512_fmadd_ps(m0, m0, acc0);
+        acc1 = _mm512_fmadd_ps(m1, m1, acc1);
+    }
+    for (; i + 16 <= vector_num_dimension; i += 16) {
+        const __m512 m = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+        acc0 = _mm512_fmadd_ps(m, m, acc0);
+    }
+    if (avx512_tail_mask != 0) {
+        const __m512 m = _mm512_sub_ps(_mm512_maskz_loadu_ps(avx512_tail_mask, a + i),
+                                       _mm512_maskz_loadu_ps(avx512_tail_mask, b + i));
+        acc1 = _mm512_fmadd_ps(m, m, acc1);
+    }
+    return HorizontalSum(_mm512_add_ps(acc0, acc1));
+}
+
+__attribute__((target("avx512f")))
+float32_t L2AVX512Bounded(const float32_t* a, const float32_t* b, float32_t bound) {
+    __m512 acc = _mm512_setzero_ps();
+    uint32_t i = 0;
+    while (i + abandon_stride <= vector_num_dimension) {
+        for (const uint32_t stop = i + abandon_stride; i < stop; i += 16) {
+            const __m512 m = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+            acc = _mm512_fmadd_ps(m, m, acc);
+        }
+        const float32_t partial = HorizontalSum(acc);
+        if (partial > bound)
+            return partial;
+    }
+    for (; i + 16 <= vector_num_dimension; i += 16) {
+        const __m512 m = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+        acc = _mm512_fmadd_ps(m, m, acc);
+    }
+    if (avx512_tail_mask != 0) {
+        const __m512 m = _mm512_sub_ps(_mm512_maskz_loadu_ps(avx512_tail_mask, a + i),
+                                       _mm512_maskz_loadu_ps(avx512_tail_mask, b + i));
+        acc = _mm512_fmadd_ps(m, m, acc);
+    }
+    return HorizontalSum(acc);
+}
+
+__attribute__((target("avx512f")))
+float32_t DotAVX512(const float32_t* a, const float32_t* b) {
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    uint32_t i = 0;
+    for (; i + 32 <= vector_num_dimension; i += 32) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), acc1);
+    }
+    for (; i + 16 <= vector_num_dimension; i += 16) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+    }
+    if (avx512_tail_mask != 0) {
+        acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(avx512_tail_mask, a + i),
+                               _mm512_maskz_loadu_ps(avx512_tail_mask, b + i), acc1);
+    }
+    return HorizontalSum(_mm512_add_ps(acc0, acc1));
+}
+
+/* the squares of dimensions [i, i + 16) added to acc. codes, minimum and step are
+ * padded, so only the query needs a masked load */
+__attribute__((target("avx512f"), always_inline))
+inline __m512 AddQuantizedSquares(__m512 acc, const float32_t* a, const uint8_t* codes, const float32_t* minimum,
+                                  const float32_t* step, const uint32_t i) {
+    /* masked conversions, for the same reason as in HorizontalSum */
+    const __m512i widened = _mm512_maskz_cvtepu8_epi32(0xffff, _mm_loadu_si128((const __m128i*) (codes + i)));
+    const __m512 code = _mm512_maskz_cvtepi32_ps(0xffff, widened);
+    const __m512 decoded = _mm512_fmadd_ps(_mm512_loadu_ps(step + i), code, _mm512_loadu_ps(minimum + i));
+    const __m512 query = i + 16 <= vector_num_dimension
+        ? _mm512_loadu_ps(a + i)
+        : _mm512_maskz_loadu_ps(avx512_tail_mask, a + i);
+    const __m512 m = _mm512_sub_ps(query, decoded);
+    return _mm512_fmadd_ps(m, m, acc);
+}
+
+__attribute__((target("avx512f")))
+float32_t L2QuantizedAVX512(const float32_t* a, const uint8_t* codes, const float32_t* minimum, const float32_t* step) {
+    __m512 acc = _mm512_setzero_ps();
+    for (uint32_t i = 0; i < vector_num_dimension; i += 16) {
+        acc = AddQuantizedSquares(acc, a, codes, minimum, step, i);
+    }
+    return HorizontalSum(acc);
+}
+
+__attribute__((target("avx512f")))
+float32_t L2QuantizedAVX512Bounded(const float32_t* a, const uint8_t* codes, const float32_t* minimum,
+                                   const float32_t* step, float32_t bound) {
+    __m512 acc = _mm512_setzero_ps();
+    uint32_t i = 0;
+    while (i + abandon_stride <= vector_num_dimension) {
+        for (const uint32_t stop = i + abandon_stride; i < stop; i += 16) {
+            acc = AddQuantizedSquares(acc, a, codes, minimum, step, i);
+        }
+        const float32_t partial = HorizontalSum(acc);
+        if (partial > bound)
+            return partial;
+    }
+    for (; i < vector_num_dimension; i += 16) {
+        acc = AddQuantizedSquares(acc, a, codes, minimum, step, i);
+    }
+    return HorizontalSum(acc);
+}
+
+#endif
+
+DistanceKernels SelectDistanceKernels() {
+    #ifdef SIGMOD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return { "avx512", L2AVX512, L2AVX512Bounded, DotAVX512, L2QuantizedAVX512, L2QuantizedAVX512Bounded };
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return { "avx2", L2AVX2, L2AVX2Bounded, DotAVX2, L2QuantizedAVX2, L2QuantizedAVX2Bounded };
+    if (__builtin_cpu_supports("sse3"))
+        return { "sse", L2SSE, L2SSEBounded, DotSSE, L2QuantizedSSE, L2QuantizedSSEBounded };
+    #endif
+    return { "scalar", L2Scalar, L2ScalarBounded, DotScalar, L2QuantizedScalar, L2QuantizedScalarBounded };
+}
+
+const DistanceKernels SIGMOD_DISTANCE_KERNELS = SelectDistanceKernels();
@@ -0,0 +1,10 @@
+#include <sigmod/graph.hh>
+
+void Graph::Free(Graph*& graph) {
+    if (graph != nullptr) {
+        sfree(graph->degrees);
+        sfree(graph->neighbors);
+        sfree(graph);
+        graph = nullptr;
+    }
+}
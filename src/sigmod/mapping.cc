@@ -0,0 +1,61 @@
+#include <sigmod/mapping.hh>
+#include <sigmod/debug.hh>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+Mapping MapFile(std::string input_path) {
+    int fd = open(input_path.c_str(), O_RDONLY);
+    if (fd < 0)
+        Panic("unable to open " + input_path + ": " + std::strerror(errno));
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+        Panic("unable to stat " + input_path + ": " + std::strerror(errno));
+    const uint64_t length = info.st_size;
+    if (length == 0)
+        Panic(input_path + " is empty");
+
+    /* Populating up front spares the query threads from faulting pages in one by one,
+     * which also makes MADV_WILLNEED redundant. No MADV_HUGEPAGE either: a private
+     * read-only file mapping stays in the page cache, where it isn't backed by them. */
+    void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED)
+        Panic("unable to map " + input_path + ": " + std::strerror(errno));
+
+    return {
+        .address = address,
+        .length = length
+    };
+}
+
+void UnmapFile(Mapping& mapping) {
+    if (mapping.address == nullptr)
+        return;
+    munmap(mapping.address, mapping.length);
+    mapping.address = nullptr;
+    mapping.length = 0;
+}
+
+uint64_t FileSize(std::string input_path) {
+    struct stat info;
+    if (stat(input_path.c_str(), &info) != 0)
+        Panic("unable to stat " + input_path + ": " + std::strerror(errno));
+    return info.st_size;
+}
+
+bool FileExists(std::string input_path) {
+    struct stat info;
+    return stat(input_path.c_str(), &info) == 0;
+}
+
+void CheckFileLength(std::string input_path, uint64_t file_size, uint32_t length, uint64_t item_size) {
+    const uint64_t expected = sizeof(uint32_t) + item_size * length;
+    if (file_size != expected)
+        Panic(input_path + " declares " + std::to_string(length) + " items, so it should be "
+              + std::to_string(expected) + " bytes long, but it is " + std::to_string(file_size));
+}
@@ -0,0 +1,133 @@
+#include <sigmod/memory.hh>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+const char* memory_tag_names[memory_tag_count] = {
+    "database", "query_set", "tree_nodes", "hyperplanes", "leaf_indices",
+    "quantized", "graph", "categories", "planner", "solution", "other"
+};
+
+struct Allocation {
+    uint64_t bytes;
+    memory_tag_t tag;
+};
+
+/* allocations are few and large, a lock per allocation costs nothing */
+std::mutex SIGMOD_MEMORY_MUTEX;
+std::unordered_map<uintptr_t, Allocation> SIGMOD_ALLOCATIONS;
+MemoryUsage SIGMOD_MEMORY_USAGE = {};
+
+/* by address, so that the compiler doesn't take the fresh allocations for read */
+void Track(const uintptr_t address, const uint64_t bytes, const memory_tag_t tag) {
+    std::lock_guard<std::mutex> lock(SIGMOD_MEMORY_MUTEX);
+    SIGMOD_ALLOCATIONS[address] = { bytes, tag };
+    MemoryUsage& usage = SIGMOD_MEMORY_USAGE;
+    usage.current += bytes;
+    usage.by_tag[tag] += bytes;
+    usage.peak = std::max(usage.peak, usage.current);
+    usage.phase_peak = std::max(usage.phase_peak, usage.current);
+    usage.peak_by_tag[tag] = std::max(usage.peak_by_tag[tag], usage.by_tag[tag]);
+}
+
+void TrackAllocation(const void* ptr, const uint64_t bytes, const memory_tag_t tag) {
+    Track((uintptr_t) ptr, bytes, tag);
+}
+
+/* the tag ptr was tracked with, MEMORY_OTHER if it wasn't */
+memory_tag_t Untrack(const void* ptr) {
+    std::lock_guard<std::mutex> lock(SIGMOD_MEMORY_MUTEX);
+    auto allocation = SIGMOD_ALLOCATIONS.find((uintptr_t) ptr);
+    if (allocation == SIGMOD_ALLOCATIONS.end())
+        return MEMORY_OTHER;
+    const memory_tag_t tag = allocation->second.tag;
+    SIGMOD_MEMORY_USAGE.current -= allocation->second.bytes;
+    SIGMOD_MEMORY_USAGE.by_tag[tag] -= allocation->second.bytes;
+    SIGMOD_ALLOCATIONS.erase(allocation);
+    return tag;
+}
+
+void UntrackAllocation(const void* ptr) {
+    Untrack(ptr);
+}
+
+/* 0 where /proc isn't there */
+uint64_t ResidentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0;
+    uint64_t resident = 0;
+    if (!(statm >> size >> resident))
+        return 0;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+MemoryUsage ReadMemoryUsage() {
+    MemoryUsage usage;
+    {
+        std::lock_guard<std::mutex> lock(SIGMOD_MEMORY_MUTEX);
+        usage = SIGMOD_MEMORY_USAGE;
+    }
+    rusage resources = {};
+    getrusage(RUSAGE_SELF, &resources);
+    usage.rss = ResidentBytes();
+    usage.peak_rss = (uint64_t) resources.ru_maxrss * 1024;
+    return usage;
+}
+
+MemoryUsage EndMemoryPhase() {
+    const MemoryUsage usage = ReadMemoryUsage();
+    std::lock_guard<std::mutex> lock(SIGMOD_MEMORY_MUTEX);
+    SIGMOD_MEMORY_USAGE.phase_peak = SIGMOD_MEMORY_USAGE.current;
+    return usage;
+}
+
+inline void* Checked(void* ptr, const uint64_t bytes, const memory_tag_t tag, const std::string& help) {
+    if (ptr == nullptr)
+        Panic("unable to allocate " + BytesToString(bytes) + " for " + help);
+    Track((uintptr_t) ptr, bytes, tag);
+    return ptr;
+}
+
+void* Allocate(const uint64_t bytes, const memory_tag_t tag, const std::string& help) {
+    return Checked(std::malloc(std::max<uint64_t>(bytes, 1)), bytes, tag, help);
+}
+
+void* AllocateZeroed(const uint64_t bytes, const memory_tag_t tag, const std::string& help) {
+    return Checked(std::calloc(std::max<uint64_t>(bytes, 1), 1), bytes, tag, help);
+}
+
+/* untracked first, so that nobody else can be given ptr and track it in between */
+void* Reallocate(void* ptr, const uint64_t bytes, const std::string& help) {
+    const memory_tag_t tag = Untrack(ptr);
+    void* reallocated = std::realloc(ptr, std::max<uint64_t>(bytes, 1));
+    if (reallocated == nullptr)
+        Panic("unable to reallocate " + BytesToString(bytes) + " for " + help);
+    Track((uintptr_t) reallocated, bytes, tag);
+    return reallocated;
+}
+
+void* AllocateAligned(const uint64_t bytes, uint64_t alignment, const memory_tag_t tag, const std::string& help) {
+    #ifdef ENABLE_HUGE_PAGES
+    if (bytes >= HUGE_PAGE_LENGTH)
+        alignment = std::max<uint64_t>(alignment, HUGE_PAGE_LENGTH);
+    #endif
+    const uint64_t size = std::max<uint64_t>((bytes + alignment - 1) / alignment, 1) * alignment;
+    void* ptr = Checked(std::aligned_alloc(alignment, size), size, tag, help);
+    #ifdef ENABLE_HUGE_PAGES
+    if (alignment >= HUGE_PAGE_LENGTH)
+        madvise(ptr, size, MADV_HUGEPAGE);
+    #endif
+    return ptr;
+}
+
+void Deallocate(void* ptr) {
+    if (ptr == nullptr)
+        return;
+    UntrackAllocation(ptr);
+    std::free(ptr);
+}
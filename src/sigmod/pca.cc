@@ -0,0 +1,125 @@
+#include <sigmod/pca.hh>
+#include <sigmod/distance.hh>
+#include <sigmod/memory.hh>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/* Cyclic Jacobi: a is a symmetric n×n matrix, row major, which is diagonalized in place.
+ * On return its diagonal holds the eigenvalues and the columns of vectors the eigenvectors. */
+static void Jacobi(double* a, double* vectors, const uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        for (uint32_t j = 0; j < n; j++) {
+            vectors[i * n + j] = i == j;
+        }
+    }
+    for (uint32_t sweep = 0; sweep < 64; sweep++) {
+        double off = 0;
+        double diagonal = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            diagonal += a[i * n + i] * a[i * n + i];
+            for (uint32_t j = i + 1; j < n; j++) {
+                off += a[i * n + j] * a[i * n + j];
+            }
+        }
+        if (off <= 1e-22 * diagonal)
+            break;
+
+        for (uint32_t p = 0; p < n; p++) {
+            for (uint32_t q = p + 1; q < n; q++) {
+                const double apq = a[p * n + q];
+                if (apq == 0)
+                    continue;
+                const double theta = (a[q * n + q] - a[p * n + p]) / (2 * apq);
+                const double t = (theta >= 0 ? 1 : -1) / (std::fabs(theta) + std::sqrt(theta * theta + 1));
+                const double c = 1 / std::sqrt(t * t + 1);
+                const double s = t * c;
+                for (uint32_t k = 0; k < n; k++) {
+                    const double akp = a[k * n + p];
+                    const double akq = a[k * n + q];
+                    a[k * n + p] = c * akp - s * akq;
+                    a[k * n + q] = s * akp + c * akq;
+                }
+                for (uint32_t k = 0; k < n; k++) {
+                    const double apk = a[p * n + k];
+                    const double aqk = a[q * n + k];
+                    a[p * n + k] = c * apk - s * aqk;
+                    a[q * n + k] = s * apk + c * aqk;
+                }
+                for (uint32_t k = 0; k < n; k++) {
+                    const double vkp = vectors[k * n + p];
+                    const double vkq = vectors[k * n + q];
+                    vectors[k * n + p] = c * vkp - s * vkq;
+                    vectors[k * n + q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+}
+
+PCA* PCA::New(const float32_t* vectors, const uint32_t length, const uint32_t stride) {
+    const uint32_t n = vector_num_dimension;
+    const uint32_t sample_length = std::min<uint32_t>(length, PCA_TRAINING_LENGTH);
+    PCA* pca = smalloc<PCA>(1, "pca", MEMORY_DATABASE);
+
+    /* covariance of an evenly strided sample */
+    std::vector<double> mean(n, 0.0);
+    for (uint32_t s = 0; s < sample_length; s++) {
+        const float32_t* row = vectors + (uint64_t) s * length / sample_length * stride;
+        for (uint32_t d = 0; d < n; d++) {
+            mean[d] += row[d];
+        }
+    }
+    for (uint32_t d = 0; d < n; d++) {
+        mean[d] /= std::max<uint32_t>(sample_length, 1);
+    }
+    std::vector<double> covariance(n * n, 0.0);
+    #ifdef ENABLE_OMP
+    #pragma omp parallel for schedule(dynamic, 1)
+    #endif
+    for (uint32_t i = 0; i < n; i++) {
+        for (uint32_t s = 0; s < sample_length; s++) {
+            const float32_t* row = vectors + (uint64_t) s * length / sample_length * stride;
+            const double centered = row[i] - mean[i];
+            for (uint32_t j = i; j < n; j++) {
+                covariance[i * n + j] += centered * (row[j] - mean[j]);
+            }
+        }
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        for (uint32_t j = i; j < n; j++) {
+            covariance[i * n + j] /= std::max<uint32_t>(sample_length, 1);
+            covariance[j * n + i] = covariance[i * n + j];
+        }
+    }
+
+    std::vector<double> eigenvectors(n * n);
+    Jacobi(covariance.data(), eigenvectors.data(), n);
+    std::vector<uint32_t> order(n);
+    for (uint32_t i = 0; i < n; i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&covariance, n](const uint32_t a, const uint32_t b) {
+        return covariance[a * n + a] > covariance[b * n + b];
+    });
+    for (uint32_t c = 0; c < PCA_COMPONENTS; c++) {
+        pca->variances[c] = std::max(0.0, covariance[order[c] * n + order[c]]);
+        for (uint32_t d = 0; d < n; d++) {
+            pca->components[c * n + d] = eigenvectors[d * n + order[c]];
+        }
+    }
+    return pca;
+}
+
+void PCA::Free(PCA*& pca) {
+    if (pca != nullptr) {
+        sfree(pca);
+        pca = nullptr;
+    }
+}
+
+void PCA::project(const float32_t* fields, float32_t* output) const {
+    for (uint32_t c = 0; c < PCA_COMPONENTS; c++) {
+        output[c] = SIGMOD_DISTANCE_KERNELS.dot(component(c), fields);
+    }
+}
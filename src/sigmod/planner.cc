@@ -0,0 +1,132 @@
+#include <sigmod/planner.hh>
+#include <sigmod/debug.hh>
+#include <algorithm>
+
+void Planner::Free(Planner*& planner) {
+    if (planner != nullptr) {
+        sfree(planner->C_values);
+        sfree(planner->C_counts);
+        sfree(planner->T_histogram);
+        sfree(planner->by_T);
+        sfree(planner);
+        planner = nullptr;
+    }
+}
+
+uint32_t Planner::count_C(const float32_t value) const {
+    const float32_t* begin = C_values;
+    const float32_t* end = C_values + C_length;
+    const float32_t* found = std::lower_bound(begin, end, value);
+    if (found == end || *found != value)
+        return 0;
+    return C_counts[found - C_values];
+}
+
+double Planner::estimate_T(const float32_t l, const float32_t r) const {
+    if (length == 0 || r < l || r < min_T || l > max_T)
+        return 0;
+    if (!(max_T > min_T))
+        return length;
+    /* records at or below T, assuming they are spread evenly inside each bucket */
+    auto below = [this](const float32_t T) {
+        if (T >= max_T)
+            return (double) length;
+        if (T < min_T)
+            return 0.0;
+        const double position = (T - min_T) / (max_T - min_T) * PLANNER_T_BUCKETS;
+        const uint32_t bucket = bucket_of(T);
+        const double fraction = std::clamp<double>(position - bucket, 0, 1);
+        return T_histogram[bucket] + fraction * (T_histogram[bucket + 1] - T_histogram[bucket]);
+    };
+    return std::max(0.0, below(r) - below(l));
+}
+
+Plan Planner::plan(const Query& query) const {
+    Plan plan = { ROUTE_SCAN_ALL, (double) length, length, false };
+    const uint32_t query_type = (uint32_t) query.query_type;
+    uint32_t in_C = 0;
+    if (query_type == BY_C || query_type == BY_C_AND_T) {
+        in_C = count_C(query.v);
+        plan.estimate = in_C;
+        if (categories != nullptr) {
+            plan.route = ROUTE_SCAN_BY_C;
+            plan.cost = in_C;
+        }
+    }
+    if (query_type == BY_T || query_type == BY_C_AND_T) {
+        const double in_T = estimate_T(query.l, query.r);
+        plan.estimate = query_type == BY_T ? in_T : plan.estimate * in_T / std::max<uint32_t>(length, 1);
+        if (in_T < plan.cost) {
+            plan.route = ROUTE_SCAN_BY_T;
+            plan.cost = (uint32_t) std::ceil(in_T);
+        }
+    }
+    if (plan.cost > PLANNER_SCAN_LENGTH)
+        plan.route = ROUTE_INDEX;
+    /* The tree of the category only reaches the records of SEARCH_LEAF_BUDGET leaves, whether
+     * they match T or not, so when fewer records than that match both filters it would miss
+     * most of them, and the category is scanned instead, however large */
+    if (plan.route == ROUTE_INDEX && query_type == BY_C_AND_T && categories != nullptr) {
+        const double reached = std::min<double>(in_C, (double) SEARCH_LEAF_BUDGET * TREE_LEAF_LENGTH);
+        if (plan.estimate < reached) {
+            plan.route = ROUTE_SCAN_BY_C;
+            plan.cost = in_C;
+            plan.selective = true;
+        }
+    }
+    return plan;
+}
+
+void Planner::record(const Query& query, const Plan& plan) const {
+    const uint32_t query_type = std::min<uint32_t>(query.query_type, query_type_count - 1);
+    #ifdef ENABLE_OMP
+    #pragma omp atomic
+    #endif
+    counters.routed[query_type][plan.route]++;
+    if (plan.selective) {
+        #ifdef ENABLE_OMP
+        #pragma omp atomic
+        #endif
+        counters.selective[query_type]++;
+    }
+}
+
+void Planner::record(const Query& query, const Plan& plan, uint32_t matched) const {
+    const uint32_t query_type = std::min<uint32_t>(query.query_type, query_type_count - 1);
+    record(query, plan);
+    #ifdef ENABLE_OMP
+    #pragma omp atomic
+    #endif
+    counters.scanned[query_type]++;
+    #ifdef ENABLE_OMP
+    #pragma omp atomic
+    #endif
+    counters.estimated[query_type] += plan.estimate;
+    #ifdef ENABLE_OMP
+    #pragma omp atomic
+    #endif
+    counters.matched[query_type] += matched;
+    #ifdef ENABLE_OMP
+    #pragma omp atomic
+    #endif
+    counters.absolute_error[query_type] += std::fabs(plan.estimate - matched);
+}
+
+void LogPlanner(const Planner& planner) {
+    static const char* route_names[route_count] = { "index", "scan all", "scan by C", "scan by T" };
+    const PlannerCounters& counters = planner.counters;
+    for (uint32_t query_type = 0; query_type < query_type_count; query_type++) {
+        std::string line = "Planner | type " + std::to_string(query_type);
+        for (uint32_t route = 0; route < route_count; route++) {
+            line += " | " + std::string(route_names[route]) + " " + std::to_string(counters.routed[query_type][route]);
+        }
+        line += " | selective " + std::to_string(counters.selective[query_type]);
+        if (counters.scanned[query_type] > 0) {
+            const double scanned = counters.scanned[query_type];
+            line += " | mean estimate " + std::to_string(counters.estimated[query_type] / scanned)
+                + " | mean matched " + std::to_string(counters.matched[query_type] / scanned)
+                + " | mean absolute error " + std::to_string(counters.absolute_error[query_type] / scanned);
+        }
+        Debug(line);
+    }
+}
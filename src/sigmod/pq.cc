@@ -0,0 +1,99 @@
+#include <sigmod/pq.hh>
+#include <cmath>
+#include <cstring>
+
+void PQ::Free(PQ*& pq) {
+    if (pq != nullptr) {
+        sfree(pq->codebooks);
+        sfree(pq->codes);
+        sfree(pq);
+        pq = nullptr;
+    }
+}
+
+inline float32_t SliceDistance(const float32_t* a, const float32_t* b) {
+    float32_t sum = 0;
+    for (uint32_t d = 0; d < pq_subspace_dimensions; d++) {
+        const float32_t m = a[d] - b[d];
+        sum += m * m;
+    }
+    return sum;
+}
+
+/* the nearest of the PQ_CENTROIDS centroids of one subspace */
+inline uint32_t NearestCentroid(const float32_t* centroids, const float32_t* slice) {
+    uint32_t nearest = 0;
+    float32_t nearest_distance = INFINITY;
+    for (uint32_t c = 0; c < PQ_CENTROIDS; c++) {
+        const float32_t distance = SliceDistance(centroids + c * pq_subspace_dimensions, slice);
+        if (distance < nearest_distance) {
+            nearest = c;
+            nearest_distance = distance;
+        }
+    }
+    return nearest;
+}
+
+void PQ::train(const float32_t* sample, uint32_t sample_length, uint64_t seed) {
+    std::memset(codebooks, 0, sizeof(float32_t) * PQ_SUBSPACES * PQ_CENTROIDS * pq_subspace_dimensions);
+    if (sample_length == 0)
+        return;
+
+    #ifdef ENABLE_OMP
+    #pragma omp parallel for schedule(dynamic, 1)
+    #endif
+    for (uint32_t m = 0; m < PQ_SUBSPACES; m++) {
+        Xoshiro256 generator = Xoshiro256::Stream(seed, m);
+        float32_t* centroids = codebooks + (uint64_t) m * PQ_CENTROIDS * pq_subspace_dimensions;
+        auto slice_of = [sample, m](const uint32_t i) {
+            return sample + (uint64_t) i * vector_num_dimension + m * pq_subspace_dimensions;
+        };
+
+        for (uint32_t c = 0; c < PQ_CENTROIDS; c++) {
+            std::memcpy(centroids + c * pq_subspace_dimensions, slice_of(generator.uniform(0u, sample_length)),
+                        sizeof(float32_t) * pq_subspace_dimensions);
+        }
+
+        float32_t sums[PQ_CENTROIDS * pq_subspace_dimensions];
+        uint32_t counts[PQ_CENTROIDS];
+        for (uint32_t iteration = 0; iteration < PQ_TRAINING_ITERATIONS; iteration++) {
+            std::memset(sums, 0, sizeof(sums));
+            std::memset(counts, 0, sizeof(counts));
+            for (uint32_t i = 0; i < sample_length; i++) {
+                const float32_t* slice = slice_of(i);
+                const uint32_t c = NearestCentroid(centroids, slice);
+                counts[c]++;
+                for (uint32_t d = 0; d < pq_subspace_dimensions; d++) {
+                    sums[c * pq_subspace_dimensions + d] += slice[d];
+                }
+            }
+            for (uint32_t c = 0; c < PQ_CENTROIDS; c++) {
+                float32_t* centroid = centroids + c * pq_subspace_dimensions;
+                if (counts[c] == 0) {
+                    /* an empty cluster restarts from a random point */
+                    std::memcpy(centroid, slice_of(generator.uniform(0u, sample_length)),
+                                sizeof(float32_t) * pq_subspace_dimensions);
+                    continue;
+                }
+                for (uint32_t d = 0; d < pq_subspace_dimensions; d++) {
+                    centroid[d] = sums[c * pq_subspace_dimensions + d] / counts[c];
+                }
+            }
+        }
+    }
+}
+
+void PQ::encode(const float32_t* vector, uint8_t* code) const {
+    for (uint32_t m = 0; m < PQ_SUBSPACES; m++) {
+        code[m] = (uint8_t) NearestCentroid(centroid(m, 0), vector + m * pq_subspace_dimensions);
+    }
+}
+
+void PQ::lookup_table(const float32_t* vector, float32_t* table) const {
+    for (uint32_t m = 0; m < PQ_SUBSPACES; m++) {
+        const float32_t* slice = vector + m * pq_subspace_dimensions;
+        for (uint32_t c = 0; c < PQ_CENTROIDS; c++) {
+            table[m * PQ_CENTROIDS + c] = SliceDistance(centroid(m, c), slice);
+        }
+    }
+}
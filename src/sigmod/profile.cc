@@ -0,0 +1,203 @@
+#include <sigmod/profile.hh>
+#include <sigmod/debug.hh>
+#include <sigmod/memory.hh>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <vector>
+#ifdef ENABLE_PERF_COUNTERS
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const char* counter_names[counter_count] = {
+    "queries", "distances", "nodes", "leaves", "insertions", "pruned_subtrees", "pruned_records"
+};
+
+const char* profile_type_names[profile_type_count] = {
+    "normal", "by_c", "by_t", "by_c_and_t", "other"
+};
+
+struct Phase {
+    std::string name;
+    double milliseconds;
+    long long cycles;
+    long long llc_misses;
+    MemoryUsage memory;
+};
+
+/* the profiles are never freed, threads may count until the end of the process */
+std::mutex SIGMOD_PROFILES_MUTEX;
+std::vector<Profile*> SIGMOD_PROFILES;
+std::vector<Phase> SIGMOD_PHASES;
+long long SIGMOD_PHASE_CYCLES = 0;
+long long SIGMOD_PHASE_LLC_MISSES = 0;
+
+#ifdef ENABLE_PERF_COUNTERS
+/* counts for the calling thread only, on any cpu, in user space */
+int OpenPerfCounter(const uint32_t type, const uint64_t config) {
+    perf_event_attr attributes = {};
+    attributes.size = sizeof(attributes);
+    attributes.type = type;
+    attributes.config = config;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    return (int) syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+}
+
+long long ReadPerfCounter(const int fd) {
+    long long value = 0;
+    if (fd < 0 || read(fd, &value, sizeof(value)) != sizeof(value))
+        return 0;
+    return value;
+}
+
+/* Closes the descriptors of the thread when it exits, keeping what they counted,
+ * since the counters of an exited thread can't count anymore anyway */
+struct PerfCounterCloser {
+    Profile* profile = nullptr;
+
+    ~PerfCounterCloser() {
+        if (profile == nullptr)
+            return;
+        std::lock_guard<std::mutex> lock(SIGMOD_PROFILES_MUTEX);
+        profile->closed_cycles += ReadPerfCounter(profile->cycles);
+        profile->closed_llc_misses += ReadPerfCounter(profile->llc_misses);
+        if (profile->cycles >= 0)
+            close(profile->cycles);
+        if (profile->llc_misses >= 0)
+            close(profile->llc_misses);
+        profile->cycles = -1;
+        profile->llc_misses = -1;
+    }
+};
+
+thread_local PerfCounterCloser SIGMOD_PERF_COUNTER_CLOSER;
+#endif
+
+Profile* RegisterProfile() {
+    Profile* profile = new Profile();
+    #ifdef ENABLE_PERF_COUNTERS
+    profile->cycles = OpenPerfCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    profile->llc_misses = OpenPerfCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    SIGMOD_PERF_COUNTER_CLOSER.profile = profile;
+    #else
+    profile->cycles = -1;
+    profile->llc_misses = -1;
+    #endif
+    std::lock_guard<std::mutex> lock(SIGMOD_PROFILES_MUTEX);
+    SIGMOD_PROFILES.push_back(profile);
+    return profile;
+}
+
+/* threads may still be counting, so the totals of a running workload are approximate */
+ProfileTotals TotalProfile() {
+    ProfileTotals total = {};
+    std::lock_guard<std::mutex> lock(SIGMOD_PROFILES_MUTEX);
+    for (const Profile* profile : SIGMOD_PROFILES) {
+        for (uint32_t t = 0; t < profile_type_count; t++) {
+            for (uint32_t c = 0; c < counter_count; c++) {
+                total.counts[t][c] += profile->counts[t][c].load(std::memory_order_relaxed);
+            }
+        }
+    }
+    return total;
+}
+
+/* a thread counting meanwhile may overwrite the reset of its own counter */
+void ResetProfile() {
+    std::lock_guard<std::mutex> lock(SIGMOD_PROFILES_MUTEX);
+    for (Profile* profile : SIGMOD_PROFILES) {
+        for (uint32_t t = 0; t < profile_type_count; t++) {
+            for (uint32_t c = 0; c < counter_count; c++) {
+                profile->counts[t][c].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+void ProfilePhase(const std::string& name, const double milliseconds) {
+    Phase phase = { name, milliseconds, -1, -1, EndMemoryPhase() };
+    #ifdef ENABLE_PERF_COUNTERS
+    /* the thread logging the phases always counts, whether it searches or not */
+    if (SIGMOD_THREAD_PROFILE == nullptr)
+        SIGMOD_THREAD_PROFILE = RegisterProfile();
+    long long cycles = 0;
+    long long llc_misses = 0;
+    bool available = false;
+    {
+        std::lock_guard<std::mutex> lock(SIGMOD_PROFILES_MUTEX);
+        for (const Profile* profile : SIGMOD_PROFILES) {
+            cycles += profile->closed_cycles + ReadPerfCounter(profile->cycles);
+            llc_misses += profile->closed_llc_misses + ReadPerfCounter(profile->llc_misses);
+            available |= profile->cycles >= 0 || profile->closed_cycles > 0;
+        }
+    }
+    if (available) {
+        phase.cycles = cycles - SIGMOD_PHASE_CYCLES;
+        phase.llc_misses = llc_misses - SIGMOD_PHASE_LLC_MISSES;
+    }
+    SIGMOD_PHASE_CYCLES = cycles;
+    SIGMOD_PHASE_LLC_MISSES = llc_misses;
+    #endif
+    SIGMOD_PHASES.push_back(phase);
+}
+
+/* name as a JSON string, quotes included */
+std::string JsonString(const std::string& name) {
+    std::string escaped = "\"";
+    for (const char c : name) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if ((unsigned char) c < 0x20) {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", (unsigned int) c);
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped + "\"";
+}
+
+void WriteProfile(std::ostream& output) {
+    output << "{\n  \"phases\": [\n";
+    for (uint32_t i = 0; i < SIGMOD_PHASES.size(); i++) {
+        const Phase& phase = SIGMOD_PHASES[i];
+        output << "    { \"name\": " << JsonString(phase.name) << ", \"ms\": " << phase.milliseconds;
+        if (phase.cycles >= 0)
+            output << ", \"cycles\": " << phase.cycles << ", \"llc_misses\": " << phase.llc_misses;
+        output << ", \"allocated_bytes\": " << phase.memory.current
+               << ", \"peak_allocated_bytes\": " << phase.memory.phase_peak
+               << ", \"rss_bytes\": " << phase.memory.rss;
+        output << " }" << (i + 1 < SIGMOD_PHASES.size() ? "," : "") << "\n";
+    }
+    output << "  ],\n  \"counters\": {\n";
+    const ProfileTotals total = TotalProfile();
+    for (uint32_t t = 0; t < profile_type_count; t++) {
+        output << "    \"" << profile_type_names[t] << "\": {";
+        for (uint32_t c = 0; c < counter_count; c++) {
+            output << (c > 0 ? ", " : " ") << "\"" << counter_names[c] << "\": " << total.counts[t][c];
+        }
+        output << " }" << (t + 1 < profile_type_count ? "," : "") << "\n";
+    }
+    output << "  },\n  \"memory\": {\n";
+    const MemoryUsage memory = ReadMemoryUsage();
+    output << "    \"peak_allocated_bytes\": " << memory.peak << ",\n";
+    output << "    \"peak_rss_bytes\": " << memory.peak_rss << ",\n";
+    output << "    \"peak_allocated_bytes_by_tag\": {";
+    for (uint32_t tag = 0; tag < memory_tag_count; tag++) {
+        output << (tag > 0 ? ", " : " ") << "\"" << memory_tag_names[tag] << "\": " << memory.peak_by_tag[tag];
+    }
+    output << " }\n  }\n}";
+}
+
+void WriteProfile(const std::string& path) {
+    std::ofstream output(path);
+    if (!output)
+        Panic("unable to open " + path + " for writing");
+    WriteProfile(output);
+    output << "\n";
+}
@@ -0,0 +1,73 @@
+#include <sigmod/quantized.hh>
+#include <sigmod/debug.hh>
+#include <sigmod/memory.hh>
+#include <sigmod/flags.hh>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+QuantizedDatabase BuildQuantizedDatabase(const ColumnarDatabase& database) {
+    const uint32_t length = database.length;
+    const uint64_t codes_size = (uint64_t) length * quantized_stride;
+
+    uint8_t* codes = (uint8_t*) AllocateAligned(codes_size, vector_alignment, MEMORY_QUANTIZED, "quantized codes");
+    float32_t* minimum = (float32_t*) AllocateZeroed(quantized_dimensions * sizeof(float32_t), MEMORY_QUANTIZED, "quantized minimum");
+    float32_t* step = (float32_t*) AllocateZeroed(quantized_dimensions * sizeof(float32_t), MEMORY_QUANTIZED, "quantized step");
+
+    float32_t maximum[vector_num_dimension];
+    for (uint32_t d = 0; d < vector_num_dimension; d++) {
+        minimum[d] = INFINITY;
+        maximum[d] = -INFINITY;
+    }
+    #ifdef ENABLE_OMP
+    #pragma omp parallel for schedule(static) reduction(min: minimum[:vector_num_dimension]) reduction(max: maximum[:vector_num_dimension])
+    #endif
+    for (uint32_t i = 0; i < length; i++) {
+        const float32_t* row = database.vectors + (uint64_t) i * vector_stride;
+        for (uint32_t d = 0; d < vector_num_dimension; d++) {
+            minimum[d] = std::min(minimum[d], row[d]);
+            maximum[d] = std::max(maximum[d], row[d]);
+        }
+    }
+    for (uint32_t d = 0; d < vector_num_dimension; d++) {
+        if (length == 0) {
+            minimum[d] = 0;
+            maximum[d] = 0;
+        }
+        step[d] = maximum[d] > minimum[d] ? (maximum[d] - minimum[d]) / 255 : 1;
+    }
+
+    #ifdef ENABLE_OMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (uint32_t i = 0; i < length; i++) {
+        const float32_t* row = database.vectors + (uint64_t) i * vector_stride;
+        uint8_t* code = codes + (uint64_t) i * quantized_stride;
+        for (uint32_t d = 0; d < vector_num_dimension; d++) {
+            code[d] = (uint8_t) std::clamp(std::lround((row[d] - minimum[d]) / step[d]), 0l, 255l);
+        }
+        std::memset(code + vector_num_dimension, 0, quantized_stride - vector_num_dimension);
+    }
+
+    return {
+        .length = length,
+        .C = database.C,
+        .T = database.T,
+        .codes = codes,
+        .minimum = minimum,
+        .step = step
+    };
+}
+
+void FreeQuantizedDatabase(QuantizedDatabase& database) {
+    if (database.codes == nullptr)
+        return;
+    Deallocate(database.codes);
+    Deallocate(database.minimum);
+    Deallocate(database.step);
+    database.codes = nullptr;
+    database.minimum = nullptr;
+    database.step = nullptr;
+    database.length = 0;
+}
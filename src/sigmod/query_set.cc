@@ -1,4 +1,7 @@
 #include <sigmod/query_set.hh>
+#include <sigmod/debug.hh>
+#include <sigmod/memory.hh>
+#include <sigmod/flags.hh>
 #include <cstdio>
 #include <iostream>
 #include <map>
@@ -6,11 +9,15 @@
 
 QuerySet ReadQuerySet(std::string input_path) {
     FILE* dbfile = fopen(input_path.c_str(), "rb");
-    
+    if (dbfile == nullptr)
+        Panic("unable to open " + input_path);
+
     uint32_t db_length;
-    fread(&db_length, sizeof(uint32_t), 1, dbfile);
+    if (fread(&db_length, sizeof(uint32_t), 1, dbfile) != 1)
+        Panic("unable to read the header of " + input_path);
+    CheckFileLength(input_path, FileSize(input_path), db_length, sizeof(Query));
 
-    Query* queries = (Query*) std::malloc(sizeof(Query) * db_length);
+    Query* queries = (Query*) Allocate(sizeof(Query) * db_length, MEMORY_QUERY_SET, input_path);
     Query* queries_entry_point = queries;
     uint32_t queries_to_read = db_length;
     while(queries_to_read > 0) {
@@ -18,7 +25,8 @@ QuerySet ReadQuerySet(std::string input_path) {
         if (this_batch > queries_to_read) {
             this_batch = queries_to_read;
         }
-        fread(queries_entry_point, sizeof(Query), this_batch, dbfile);
+        if (fread(queries_entry_point, sizeof(Query), this_batch, dbfile) != this_batch)
+            Panic("unexpected end of " + input_path);
         queries_to_read -= this_batch;
         queries_entry_point += this_batch;
     }
@@ -26,12 +34,30 @@ QuerySet ReadQuerySet(std::string input_path) {
 
     return {
         .length = db_length,
-        .queries = queries
+        .queries = queries,
+        .mapping = {nullptr, 0}
+    };
+}
+
+QuerySet MapQuerySet(std::string input_path) {
+    Mapping mapping = MapFile(input_path);
+
+    if (mapping.length < sizeof(uint32_t))
+        Panic("unable to read the header of " + input_path);
+    const uint32_t db_length = *((uint32_t*) mapping.address);
+    CheckFileLength(input_path, mapping.length, db_length, sizeof(Query));
+
+    return {
+        .length = db_length,
+        .queries = (Query*) ((char*) mapping.address + sizeof(uint32_t)),
+        .mapping = mapping
     };
 }
 
 void WriteQuerySet(QuerySet& query_set, std::string output_path) {
     FILE* output = fopen(output_path.c_str(), "wb");
+    if (output == nullptr)
+        Panic("unable to open " + output_path + " for writing");
 
     fwrite(&query_set.length, sizeof(uint32_t), 1, output);
     Query* query_set_entry_point = query_set.queries;
@@ -52,7 +78,11 @@ void WriteQuerySet(QuerySet& query_set, std::string output_path) {
 void FreeQuerySet(QuerySet& queryset) {
     if (queryset.queries == nullptr)
         return;
-    free(queryset.queries);
+    if (queryset.mapping.address != nullptr) {
+        UnmapFile(queryset.mapping);
+    } else {
+        Deallocate(queryset.queries);
+    }
     queryset.queries = nullptr;
     queryset.length = 0;
 }
@@ -1,12 +1,52 @@
 #include <sigmod/random.hh>
-#include <cstdlib>
+#include <cmath>
 
-uint32_t RandomUINT32T(uint32_t min, uint32_t max) {
-    const uint32_t width = max - min;
-    return (std::rand() % width) + min;
+uint64_t SplitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
 }
 
-float32_t RandomFLOAT32T(float32_t min, float32_t max) {
-    const float32_t width = RAND_MAX / (max - min);
-    return (static_cast<float32_t>(std::rand()) / width) + min;
+Xoshiro256 Xoshiro256::Seeded(uint64_t seed) {
+    Xoshiro256 generator;
+    for (uint32_t i = 0; i < 4; i++) {
+        generator.s[i] = SplitMix64(seed);
+    }
+    return generator;
+}
+
+Xoshiro256 Xoshiro256::Stream(uint64_t seed, uint64_t stream) {
+    Xoshiro256 generator = Seeded(seed);
+    for (uint64_t i = 0; i < stream; i++) {
+        generator.jump();
+    }
+    return generator;
+}
+
+void Xoshiro256::jump() {
+    static const uint64_t polynomial[4] = {
+        0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull
+    };
+    uint64_t jumped[4] = { 0, 0, 0, 0 };
+    for (uint32_t i = 0; i < 4; i++) {
+        for (uint32_t b = 0; b < 64; b++) {
+            if (polynomial[i] & ((uint64_t) 1 << b)) {
+                for (uint32_t j = 0; j < 4; j++) {
+                    jumped[j] ^= s[j];
+                }
+            }
+            next();
+        }
+    }
+    for (uint32_t j = 0; j < 4; j++) {
+        s[j] = jumped[j];
+    }
+}
+
+float32_t Xoshiro256::normal() {
+    /* 1 - u keeps the logarithm away from 0 */
+    const float32_t u = 1.0f - uniform(0.0f, 1.0f);
+    const float32_t v = uniform(0.0f, 1.0f);
+    return std::sqrt(-2.0f * std::log(u)) * std::cos(2.0f * (float32_t) M_PI * v);
 }
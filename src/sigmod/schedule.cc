@@ -0,0 +1,59 @@
+#include <sigmod/schedule.hh>
+#include <sigmod/memory.hh>
+#include <sigmod/flags.hh>
+#include <algorithm>
+#ifdef ENABLE_OMP
+#include <parallel/algorithm>
+#endif
+
+struct ScheduleKey {
+    uint32_t query_type;
+    uint32_t leaf;
+    float32_t primary;
+    float32_t secondary;
+    uint32_t index;
+
+    inline bool operator<(const ScheduleKey& other) const {
+        if (query_type != other.query_type)
+            return query_type < other.query_type;
+        if (leaf != other.leaf)
+            return leaf < other.leaf;
+        if (primary != other.primary)
+            return primary < other.primary;
+        if (secondary != other.secondary)
+            return secondary < other.secondary;
+        return index < other.index;
+    }
+};
+
+ScheduleKey KeyOf(const Query& query, const uint32_t index, const Tree* tree) {
+    const uint32_t query_type = (uint32_t) query.query_type;
+    switch (query_type) {
+        case BY_C: return { query_type, 0, query.v, 0, index };
+        case BY_T: return { query_type, 0, query.l, query.r, index };
+        case BY_C_AND_T: return { query_type, 0, query.v, query.l, index };
+        default: return { query_type, tree != nullptr ? tree->locate(query) : 0, 0, 0, index };
+    }
+}
+
+uint32_t* ScheduleQueries(const QuerySet& qs, const Tree* tree) {
+    ScheduleKey* keys = smalloc<ScheduleKey>(std::max<uint32_t>(qs.length, 1), "schedule keys");
+    #ifdef ENABLE_OMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (uint32_t i = 0; i < qs.length; i++) {
+        keys[i] = KeyOf(qs.queries[i], i, tree);
+    }
+    #ifdef ENABLE_OMP
+    __gnu_parallel::sort(keys, keys + qs.length);
+    #else
+    std::sort(keys, keys + qs.length);
+    #endif
+
+    uint32_t* order = smalloc<uint32_t>(std::max<uint32_t>(qs.length, 1), "schedule");
+    for (uint32_t i = 0; i < qs.length; i++) {
+        order[i] = keys[i].index;
+    }
+    sfree(keys);
+    return order;
+}
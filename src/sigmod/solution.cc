@@ -0,0 +1,46 @@
+#include <sigmod/solution.hh>
+#include <sigmod/debug.hh>
+#include <sigmod/memory.hh>
+#include <cstdio>
+#include <cstdlib>
+
+Solution NewSolution(uint32_t length) {
+    uint32_t* results = (uint32_t*) AllocateZeroed((uint64_t) length * k_nearest_neighbors * sizeof(uint32_t),
+                                                   MEMORY_SOLUTION, "a solution for " + std::to_string(length) + " queries");
+    return {
+        .length = length,
+        .results = results
+    };
+}
+
+/* the output file is headerless: length * k_nearest_neighbors uint32_t, one row per query */
+void WriteSolution(const Solution& solution, std::string output_path) {
+    FILE* output = fopen(output_path.c_str(), "wb");
+    if (output == nullptr)
+        Panic("unable to open " + output_path + " for writing");
+
+    uint32_t* results_entry_point = solution.results;
+    uint32_t results_to_write = solution.length;
+    while(results_to_write > 0) {
+        uint32_t this_batch = batch_size;
+        if (this_batch > results_to_write) {
+            this_batch = results_to_write;
+        }
+        if (fwrite(results_entry_point, sizeof(uint32_t) * k_nearest_neighbors, this_batch, output) != this_batch)
+            Panic("unable to write " + output_path);
+        results_to_write -= this_batch;
+        results_entry_point += (uint64_t) this_batch * k_nearest_neighbors;
+    }
+
+    /* buffered writes only fail for good once they are flushed */
+    if (fclose(output) != 0)
+        Panic("unable to write " + output_path);
+}
+
+void FreeSolution(Solution& solution) {
+    if (solution.results == nullptr)
+        return;
+    Deallocate(solution.results);
+    solution.results = nullptr;
+    solution.length = 0;
+}
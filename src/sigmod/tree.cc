@@ -0,0 +1,207 @@
+#include <sigmod/tree.hh>
+#include <sigmod/memory.hh>
+#include <sigmod/debug.hh>
+#include <cstdlib>
+#include <cstdio>
+
+/* every internal node holds more than TREE_LEAF_LENGTH records and gives each child
+ * at least 1 / TREE_MIN_SPLIT_FRACTION of them, which bounds the size of the leaves */
+uint32_t MaxLeaves(uint32_t length) {
+    const uint32_t min_leaf_length = std::max(1, (TREE_LEAF_LENGTH + 1) / TREE_MIN_SPLIT_FRACTION);
+    return length / min_leaf_length + 1;
+}
+
+Tree* Tree::Allocate(uint32_t length) {
+    const uint32_t max_leaves = MaxLeaves(length);
+    const uint64_t hyperplanes_size = (uint64_t) max_leaves * vector_stride * sizeof(float32_t);
+
+    Tree* tree = smalloc<Tree>(1, "tree", MEMORY_TREE_NODES);
+    tree->length = length;
+    tree->nodes_length = 0;
+    tree->hyperplanes_length = 0;
+    tree->nodes = (Node*) ::Allocate(sizeof(Node) * 2 * max_leaves, MEMORY_TREE_NODES, "tree nodes");
+    tree->summaries = (Summary*) ::Allocate(sizeof(Summary) * 2 * max_leaves, MEMORY_TREE_NODES, "tree summaries");
+    tree->hyperplanes = (float32_t*) AllocateAligned(hyperplanes_size, vector_alignment, MEMORY_HYPERPLANES, "tree hyperplanes");
+    tree->offsets = (float32_t*) ::Allocate(sizeof(float32_t) * max_leaves, MEMORY_HYPERPLANES, "tree offsets");
+    tree->by_C = smalloc<uint32_t>(std::max<uint32_t>(length, 1), "leaves by C", MEMORY_LEAF_INDICES);
+    tree->by_T = smalloc<uint32_t>(std::max<uint32_t>(length, 1), "leaves by T", MEMORY_LEAF_INDICES);
+    tree->mapping = {nullptr, 0};
+    return tree;
+}
+
+void Tree::shrink() {
+    nodes = (Node*) Reallocate(nodes, sizeof(Node) * nodes_length, "tree nodes");
+    summaries = (Summary*) Reallocate(summaries, sizeof(Summary) * nodes_length, "tree summaries");
+    offsets = (float32_t*) Reallocate(offsets, sizeof(float32_t) * hyperplanes_length, "tree offsets");
+    /* aligned allocations can't be realloc'd, so the hyperplanes are copied over */
+    const uint64_t hyperplanes_size = (uint64_t) hyperplanes_length * vector_stride * sizeof(float32_t);
+    float32_t* shrunk_hyperplanes = (float32_t*) AllocateAligned(hyperplanes_size, vector_alignment, MEMORY_HYPERPLANES, "tree hyperplanes");
+    std::memcpy(shrunk_hyperplanes, hyperplanes, hyperplanes_size);
+    Deallocate(hyperplanes);
+    hyperplanes = shrunk_hyperplanes;
+}
+
+/* whether an arena of a mapped tree points into its file, see Tree::remap */
+inline bool InMapping(const Mapping& mapping, const void* arena) {
+    const char* base = (const char*) mapping.address;
+    return (const char*) arena >= base && (const char*) arena < base + mapping.length;
+}
+
+void Tree::Free(Tree*& tree) {
+    if (tree != nullptr && tree->mapping.address != nullptr) {
+        if (!InMapping(tree->mapping, tree->by_C))
+            sfree(tree->by_C);
+        if (!InMapping(tree->mapping, tree->by_T))
+            sfree(tree->by_T);
+        UnmapFile(tree->mapping);
+        sfree(tree);
+        tree = nullptr;
+    } else if (tree != nullptr) {
+        Deallocate(tree->nodes);
+        Deallocate(tree->summaries);
+        Deallocate(tree->hyperplanes);
+        Deallocate(tree->offsets);
+        sfree(tree->by_C);
+        sfree(tree->by_T);
+        sfree(tree);
+        tree = nullptr;
+    }
+}
+
+void Tree::remap(const uint32_t* inverse) {
+    if (mapping.address != nullptr) {
+        /* mapped arenas are read only, so the leaves get copies of their own */
+        uint32_t* C = smalloc<uint32_t>(std::max<uint32_t>(length, 1), "leaves by C", MEMORY_LEAF_INDICES);
+        uint32_t* T = smalloc<uint32_t>(std::max<uint32_t>(length, 1), "leaves by T", MEMORY_LEAF_INDICES);
+        std::copy(by_C, by_C + length, C);
+        std::copy(by_T, by_T + length, T);
+        by_C = C;
+        by_T = T;
+    }
+    #ifdef ENABLE_OMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (uint32_t i = 0; i < length; i++) {
+        by_C[i] = inverse[by_C[i]];
+        by_T[i] = inverse[by_T[i]];
+    }
+}
+
+const uint64_t tree_file_alignment = 64;
+
+inline uint64_t AlignTreeFileOffset(uint64_t offset) {
+    return (offset + tree_file_alignment - 1) / tree_file_alignment * tree_file_alignment;
+}
+
+/* where each arena starts within an index file */
+struct TreeFileLayout {
+    uint64_t nodes;
+    uint64_t summaries;
+    uint64_t hyperplanes;
+    uint64_t offsets;
+    uint64_t by_C;
+    uint64_t by_T;
+    uint64_t end;
+
+    static TreeFileLayout Of(const TreeFileHeader& header) {
+        TreeFileLayout layout;
+        layout.nodes = AlignTreeFileOffset(sizeof(TreeFileHeader));
+        layout.summaries = AlignTreeFileOffset(layout.nodes + sizeof(Node) * header.nodes_length);
+        layout.hyperplanes = AlignTreeFileOffset(layout.summaries + sizeof(Summary) * header.nodes_length);
+        layout.offsets = AlignTreeFileOffset(layout.hyperplanes + sizeof(float32_t) * vector_stride * header.hyperplanes_length);
+        layout.by_C = AlignTreeFileOffset(layout.offsets + sizeof(float32_t) * header.hyperplanes_length);
+        layout.by_T = AlignTreeFileOffset(layout.by_C + sizeof(uint32_t) * header.length);
+        layout.end = layout.by_T + sizeof(uint32_t) * header.length;
+        return layout;
+    }
+};
+
+void WriteTreeSection(FILE* output, uint64_t offset, const void* data, uint64_t size) {
+    static const char padding[tree_file_alignment] = {};
+    const uint64_t position = ftell(output);
+    fwrite(padding, 1, offset - position, output);
+    fwrite(data, 1, size, output);
+}
+
+/* written next to output_path and renamed over it once complete, so that neither
+ * a crash nor another process mapping the previous index ever sees half a file */
+void WriteTree(const Tree& tree, uint64_t checksum, std::string output_path) {
+    const std::string temporary_path = output_path + ".tmp";
+    FILE* output = fopen(temporary_path.c_str(), "wb");
+    if (output == nullptr) {
+        Debug("unable to open " + temporary_path + " for writing, the index won't be saved");
+        return;
+    }
+
+    TreeFileHeader header = {};
+    std::memcpy(header.magic, tree_file_magic, sizeof(tree_file_magic));
+    header.version = tree_file_version;
+    header.vector_stride = vector_stride;
+    header.checksum = checksum;
+    header.length = tree.length;
+    header.nodes_length = tree.nodes_length;
+    header.hyperplanes_length = tree.hyperplanes_length;
+    header.seed = tree.seed;
+    const TreeFileLayout layout = TreeFileLayout::Of(header);
+
+    fwrite(&header, sizeof(TreeFileHeader), 1, output);
+    WriteTreeSection(output, layout.nodes, tree.nodes, sizeof(Node) * tree.nodes_length);
+    WriteTreeSection(output, layout.summaries, tree.summaries, sizeof(Summary) * tree.nodes_length);
+    WriteTreeSection(output, layout.hyperplanes, tree.hyperplanes, sizeof(float32_t) * vector_stride * tree.hyperplanes_length);
+    WriteTreeSection(output, layout.offsets, tree.offsets, sizeof(float32_t) * tree.hyperplanes_length);
+    WriteTreeSection(output, layout.by_C, tree.by_C, sizeof(uint32_t) * tree.length);
+    WriteTreeSection(output, layout.by_T, tree.by_T, sizeof(uint32_t) * tree.length);
+
+    const bool failed = ferror(output);
+    if (fclose(output) != 0 || failed) {
+        Debug("unable to write " + temporary_path + ", the index won't be saved");
+        std::remove(temporary_path.c_str());
+        return;
+    }
+    if (std::rename(temporary_path.c_str(), output_path.c_str()) != 0) {
+        Debug("unable to rename " + temporary_path + " to " + output_path + ", the index won't be saved");
+        std::remove(temporary_path.c_str());
+    }
+}
+
+Tree* MapTree(std::string input_path, uint64_t checksum, uint32_t length, uint32_t seed) {
+    if (!FileExists(input_path) || FileSize(input_path) < sizeof(TreeFileHeader))
+        return nullptr;
+
+    Mapping mapping = MapFile(input_path);
+    const TreeFileHeader& header = *((const TreeFileHeader*) mapping.address);
+    const char* base = (const char*) mapping.address;
+
+    std::string problem = "";
+    if (std::memcmp(header.magic, tree_file_magic, sizeof(tree_file_magic)) != 0) {
+        problem = "is not an index";
+    } else if (header.version != tree_file_version || header.vector_stride != vector_stride) {
+        problem = "was written by an incompatible version";
+    } else if (header.checksum != checksum || header.length != length) {
+        problem = "was built over another database";
+    } else if (header.seed != seed) {
+        problem = "was built with another seed";
+    } else if (TreeFileLayout::Of(header).end != mapping.length) {
+        problem = "is truncated";
+    }
+    if (problem.size() != 0) {
+        Debug(input_path + " " + problem + ", ignoring it");
+        UnmapFile(mapping);
+        return nullptr;
+    }
+
+    const TreeFileLayout layout = TreeFileLayout::Of(header);
+    Tree* tree = smalloc<Tree>(1, "tree", MEMORY_TREE_NODES);
+    tree->seed = header.seed;
+    tree->length = header.length;
+    tree->nodes_length = header.nodes_length;
+    tree->hyperplanes_length = header.hyperplanes_length;
+    tree->nodes = (Node*) (base + layout.nodes);
+    tree->summaries = (Summary*) (base + layout.summaries);
+    tree->hyperplanes = (float32_t*) (base + layout.hyperplanes);
+    tree->offsets = (float32_t*) (base + layout.offsets);
+    tree->by_C = (uint32_t*) (base + layout.by_C);
+    tree->by_T = (uint32_t*) (base + layout.by_T);
+    tree->mapping = mapping;
+    return tree;
+}